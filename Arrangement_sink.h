@@ -0,0 +1,76 @@
+#ifndef ARRANGEMENT_SINK_H
+#define ARRANGEMENT_SINK_H
+
+#include <cstddef>
+
+#include <Sphere_intersecter.h>
+
+// Receiver of the arrangement computed by the sweep of a sphere, as it
+// is computed: the arrangement is never held as a whole, only written
+// incrementally to the sink.
+//
+// The arrangement is a half-edge structure, given as:
+//  - vertices, the (interned) event points, along with the points where
+//    arcs cross the starting meridian
+//  - edges, portions of circles between two vertices, each along with
+//    the faces below and above it (that is, on each of its half-edges)
+//  - faces, along with their depth (the number of spheres covering them)
+//
+// Ids are given per sphere, in increasing order from 0. Faces are
+// virtual faces of the sweep: a single face may be split across several
+// ids, at the starting meridian and at critical events. Virtual faces
+// are merged at the end of the sweep, and given their actual face.
+//
+// The callbacks of a sphere are all made from a single thread, but
+// different spheres may be swept concurrently (see run_for_all). The
+// handles and points given may thus be copied from several threads at
+// once, which requires a thread safe CGAL (without CGAL_HAS_NO_THREADS).
+template <typename SK>
+class Arrangement_sink
+{
+  public:
+    // Geometrical objects
+    typedef typename SK::Circular_arc_point_3 Circular_arc_point_3;
+
+    // Sphere intersecter
+    typedef typename Sphere_intersecter<SK>::Circle_handle Circle_handle;
+    typedef typename Sphere_intersecter<SK>::Sphere_handle Sphere_handle;
+
+    // Ids of the arrangement's elements
+    typedef std::size_t Vertex_id;
+    typedef std::size_t Edge_id;
+    typedef std::size_t Face_id;
+
+    virtual ~Arrangement_sink() {}
+
+    // Start/end of the arrangement of a sphere
+    virtual void begin_sphere(const Sphere_handle &) {}
+    virtual void end_sphere(const Sphere_handle &) {}
+    // ...or abort, when the sweep is stopped before the end
+    virtual void abort_sphere(const Sphere_handle &) {}
+    // Drop the arrangement of a sphere being removed (its
+    // handle being invalid afterwards)
+    virtual void erase_sphere(const Sphere_handle &) {}
+
+    // New vertex, at a given point
+    virtual void vertex(const Sphere_handle &, Vertex_id,
+        const Circular_arc_point_3 &) = 0;
+
+    // New edge, lying on a given circle, from a source vertex to a
+    // target vertex (in sweep order), between two faces (below/above)
+    virtual void edge(const Sphere_handle &, Edge_id, const Circle_handle &,
+        Vertex_id, Vertex_id, Face_id, Face_id) = 0;
+
+    // New (virtual) face, with a given depth
+    virtual void face(const Sphere_handle &, Face_id, int) = 0;
+
+    // Actual face of a virtual face, once merged (actual faces being
+    // numbered from 0, in order of their first virtual face)
+    virtual void merged_face(const Sphere_handle &, Face_id, Face_id) {}
+
+    // Total area of the faces of a given depth (approximated), once the
+    // sphere is swept (only given for depths having faces)
+    virtual void depth_area(const Sphere_handle &, int, double) {}
+};
+
+#endif // ARRANGEMENT_SINK_H // vim: ft=cpp et sw=2 sts=2
@@ -1,13 +1,48 @@
 #ifndef BO_ALGORITHM_FOR_SPHERES_H
 #define BO_ALGORITHM_FOR_SPHERES_H
 
+#include <map>
+#include <set>
+#include <cmath>
+#include <deque>
 #include <vector>
+#include <iterator>
 #include <algorithm>
+#include <functional>
 
 #include <boost/thread.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/intrusive/avl_set.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 
+#include <Thread_pool.h>
+#include <Cancellation_token.h>
+#include <Union_find.h>
+#include <Spherical_utils.h>
+#include <Arrangement_sink.h>
 #include <Sphere_intersecter.h>
 #include <Event_queue.h>
+#include <Event_queue_builder.h>
+#include <Event_queue_cache.h>
+#include <Diagram_cache.h>
+#include <Sweep_frame.h>
+#include <Diagram_statistics.h>
+
+// Tracing of the sweeps (compiled out unless BO_TRACE_SWEEP is defined),
+// written to std::clog unless BO_TRACE_HOOK is defined to another sink
+#ifdef BO_TRACE_SWEEP
+# ifndef BO_TRACE_HOOK
+#  include <iostream>
+#  define BO_TRACE_HOOK(message) (std::clog << message << '\n')
+# endif
+# define BO_TRACE(message) BO_TRACE_HOOK(message)
+#else
+# define BO_TRACE(message) ((void) 0)
+#endif
 
 template <typename SK>
 class BO_algorithm_for_spheres
@@ -33,6 +68,14 @@ class BO_algorithm_for_spheres
   typedef Sphere_intersecter<SK> SI;
   typedef typename SI::Circle_handle Circle_handle;
   typedef typename SI::Sphere_handle Sphere_handle;
+  typedef typename SI::Sphere_handle_pair Sphere_handle_pair;
+  typedef typename SI::Stamp Stamp;
+
+  // Arrangement output
+  typedef Arrangement_sink<SK> Sink;
+  typedef typename Sink::Vertex_id Vertex_id;
+  typedef typename Sink::Edge_id Edge_id;
+  typedef typename Sink::Face_id Face_id;
 
   // Event queue
   typedef Event_queue<SK> EQ;
@@ -48,63 +91,448 @@ class BO_algorithm_for_spheres
   typedef typename Events::Polar_event Polar_event;
   typedef typename Events::Polar_event_site Polar_event_site;
 
-  // V-ordering
-  typedef std::list<Circular_arc_3> Vorder;
+  // Arc of the V-ordering, along with its supporting circle
+  struct V_arc: boost::intrusive::avl_set_base_hook<>
+  {
+    V_arc(const Circle_handle & c, const Circular_arc_3 & a):
+      circle(c), arc(a), upper_sites(),
+      source(0), upper_face(0), upper_depth(0), depth_delta(0) {}
+
+    Circle_handle circle;
+    Circular_arc_3 arc;
+
+    // Sites of the intersection events with the upper neighbor
+    // in V (lazy discovery), to remove when adjacency is lost
+    typename EQ::Site_handles upper_sites;
+
+    // Arrangement: vertex where the arc's current edge starts, face
+    // above the arc, and its depth (along with the depth change when
+    // crossing the arc upwards, 0 until known)
+    Vertex_id source;
+    Face_id upper_face;
+    int upper_depth;
+    int depth_delta;
+  };
+
+  // V-ordering (arcs sorted by increasing z on the sweep meridian).
+  // The order of the arcs only changes at event sites, where they are
+  // inserted at known positions, the tree being only searched by point
+  typedef boost::intrusive::avl_multiset<V_arc> Vorder;
+
+  // Arcs of V, by supporting circle (at most two per circle)
+  typedef std::multimap<Circle_handle, V_arc *> V_arc_map;
+
+  // Releases the arcs unlinked from V
+  struct Delete_arc
+  {
+    void operator()(V_arc * arc) const
+    { delete arc; }
+  };
+
+  // Position of an arc of V with respect to a point of the sweep
+  // meridian (below/above), used to search V by point
+  struct Compare_arc_to_point
+  {
+    typedef typename SK::Compare_z_at_theta_3 Compare_z_at_theta_3;
+
+    Compare_arc_to_point(const Sphere_3 & s):
+      sphere(s) {}
+
+    bool operator()(const V_arc & a, const Circular_arc_point_3 & p) const
+    { return Compare_z_at_theta_3(sphere)(p, a.arc) == CGAL::LARGER; }
+    bool operator()(const Circular_arc_point_3 & p, const V_arc & a) const
+    { return Compare_z_at_theta_3(sphere)(p, a.arc) == CGAL::SMALLER; }
+
+    const Sphere_3 & sphere;
+  };
+
+  // Order of arcs passing through a same point, right after this point
+  struct Compare_arcs_to_right
+  {
+    typedef typename SK::Compare_z_to_right_3 Compare_z_to_right_3;
+
+    Compare_arcs_to_right(const Sphere_3 & s,
+        const Circular_arc_point_3 & p):
+      sphere(s), point(p) {}
+
+    bool operator()(const V_arc * a1, const V_arc * a2) const
+    { return Compare_z_to_right_3(sphere)(a1->arc, a2->arc, point) == CGAL::SMALLER; }
+
+    const Sphere_3 & sphere;
+    const Circular_arc_point_3 & point;
+  };
 
   // Other helpers
   typedef std::vector<Object_3> Intersection_list;
   typedef std::vector<Circle_handle> Circle_handle_list;
 
-  // Handle a normal event site
-  void handle_event_site(const Normal_event_site &);
-  // ... same, but with a polar/bipolar event site
-  void handle_polar_event_site(const Polar_event_site &);
-  void handle_bipolar_event_site(const Bipolar_event_site &);
+  public:
+    // Total area of the faces of each depth of a sphere's diagram
+    typedef typename Diagram_cache<SK>::Depth_areas Depth_areas;
+
+    // Outcome of a run: completed, stopped, or completed except for
+    // degenerate spheres, for which no sweep frame avoiding their
+    // circles was found (their arrangements being aborted). The sweep
+    // doesn't handle circles through its poles (polar/bipolar circles):
+    // a sphere having some in the frame it would be swept in is never
+    // swept, and is reported as degenerate instead.
+    enum Run_status {
+      Completed, Cancelled, Timed_out, Degenerate
+    };
+
+    // Progress of the sweep of a sphere: events handled so far, out of
+    // the events known so far (which grow while sweeping in lazy mode)
+    typedef boost::function<void (const Sphere_handle &,
+        std::size_t, std::size_t)> Progress_callback;
+
+    // Options of a run: a deadline and a cancellation token (none by
+    // default), the token being checked before each event and the
+    // deadline every few events (reading the clock), and a progress
+    // callback, called every given number of events and once done
+    // (from the sweeping threads, when sweeping many spheres), along
+    // with a callback for each degenerate sphere (same threads)
+    struct Run_options
+    {
+      Run_options():
+        deadline(boost::posix_time::not_a_date_time), cancellation(0),
+        progress(), progress_interval(1 << 8), degenerate() {}
+
+      // Set the deadline a given duration from now
+      void set_time_budget(const boost::posix_time::time_duration & budget)
+      { deadline = boost::posix_time::microsec_clock::universal_time() + budget; }
+
+      boost::posix_time::ptime deadline;
+      const Cancellation_token * cancellation;
+      Progress_callback progress;
+      std::size_t progress_interval;
+      boost::function<void (const Sphere_handle &)> degenerate;
+    };
+
+  private:
+  // Status of a run so far, given its options (checking the
+  // deadline or not)
+  static Run_status run_status(const Run_options &, bool = true);
+
+  // Frame chosen for a sphere (whether found or not), along with the
+  // sphere intersecter of the frame (if not the input one), the sphere
+  // there, the input circle of each of its circles, and the sphere's
+  // scheduled event queue there (eager mode, built on first use). It's
+  // kept as long as the sphere's stamp stays the same.
+  struct Chosen_frame: boost::noncopyable
+  {
+    Chosen_frame(Stamp s):
+      stamp(s), found(false), frame(), si(), sphere(),
+      input_circles(), E() {}
+
+    Stamp stamp;
+    bool found;
+    Sweep_frame<SK> frame;
+    boost::scoped_ptr<SI> si;
+    Sphere_handle sphere;
+    std::map<Circle_handle, Circle_handle> input_circles;
+    boost::shared_ptr<const EQ> E;
+  };
+  typedef boost::shared_ptr<Chosen_frame> Chosen_frame_ptr;
+  typedef std::map<Sphere_handle, Chosen_frame_ptr> Chosen_frames;
+
+  // State of the sweep of a single sphere, so that
+  // several spheres can be swept at the same time
+  struct Sweep: boost::noncopyable
+  {
+    Sweep(const SI & i, const Sphere_handle & sh, Sink * s):
+      si(&i), sphere(sh), input_sphere(sh),
+      frame(), chosen_frame(),
+      V(), V_arcs(), E(), schedule(), cursor(), M0(),
+      sink(s), n_vertices(0), n_edges(0), faces(),
+      bottom_face(0), bottom_depth(0), seam_vertices(), seam_faces(),
+      site_vertex(0), site_face_below(0), site_face_above(0),
+      radius(std::sqrt(CGAL::to_double(sh->squared_radius()))), theta(0),
+      positions(), face_depths(), face_areas(), depth_areas() {}
+    ~Sweep()
+    { clear_V(); }
+
+    // Insert an arc in V before a given position (taking
+    // ownership of it), or remove it
+    typename Vorder::iterator insert_arc(typename Vorder::const_iterator,
+        V_arc *);
+    typename Vorder::iterator erase_arc(typename Vorder::iterator);
+    // ...remove all the arcs
+    void clear_V();
+
+    // Sphere intersecter and sphere swept, either the input ones, or
+    // those of a rotated frame, along with the input sphere
+    const SI * si;
+    Sphere_handle sphere;
+    Sphere_handle input_sphere;
+    // ...frame, as chosen (if not the input frame)
+    Sweep_frame<SK> frame;
+    Chosen_frame_ptr chosen_frame;
+
+    Vorder V;
+    V_arc_map V_arcs;
+    // Event queue (lazy mode), or scheduled event queue
+    // shared with the cache, and walked in place (eager mode)
+    EQ E;
+    boost::shared_ptr<const EQ> schedule;
+    typename EQ::Cursor cursor;
+    Circular_arc_3 M0;
+
+    // Arrangement output (if any), along with the number of
+    // vertices/edges so far (the arrangement being followed
+    // even without any sink, for the areas)
+    Sink * sink;
+    std::size_t n_vertices, n_edges;
+    // ...virtual faces given so far, along with the ones
+    // to merge (being parts of a same face)
+    Union_find faces;
+    // ...face below all the arcs, and its depth
+    Face_id bottom_face;
+    int bottom_depth;
+    // ...vertices where the initial arcs cross M0,
+    // and faces above them (in V order)
+    std::vector<Vertex_id> seam_vertices;
+    std::vector<Face_id> seam_faces;
+    // ...vertex of the event site being handled, and faces
+    // right below/above it (before the event)
+    Vertex_id site_vertex;
+    Face_id site_face_below, site_face_above;
+
+    // Areas of the faces, measured while sweeping: the area of a strip
+    // of faces between two sites being the integral of the heights of
+    // the arcs bounding them, each edge adds its integral to the faces
+    // below/above it, and the faces at the poles get the rest
+    double radius;
+    // ...theta of the last site
+    double theta;
+    // ...approximate positions of the vertices
+    std::vector<Approximate_vector_3> positions;
+    // ...depths and areas of the faces given so far
+    std::vector<int> face_depths;
+    std::vector<double> face_areas;
+    // ...summed by depth, once done
+    Depth_areas depth_areas;
+  };
+
+  // Sweep a sphere, using the thread pool or not, until
+  // done or stopped (the arrangement being then aborted)
+  Run_status run_sweep(Sweep &, bool, const Run_options &);
+  // ...handling the events of a queue (or cursor), counting them
+  template <typename Queue>
+  Run_status handle_events(Sweep &, Queue &, const Run_options &,
+      std::size_t &);
+  // ...in a frame chosen for its circles (or reused), moving them
+  // there, false if no frame avoids their degeneracies
+  bool enter_frame(Sweep &, Circle_handle_list &);
+  // ...building the sphere intersecter of a rotated frame
+  void build_frame(Chosen_frame &, const Sphere_handle &,
+      const Circle_handle_list &);
+  // ...input circle of a circle of the frame
+  static const Circle_handle & input_circle(const Sweep & sweep,
+      const Circle_handle & ch)
+  { typename std::map<Circle_handle, Circle_handle>::const_iterator it =
+      sweep.chosen_frame->input_circles.find(ch);
+    CGAL_assertion(it != sweep.chosen_frame->input_circles.end());
+    return it->second; }
+  // ...or give the trivial arrangement of a sphere without circles
+  // (a single face, as deep as the number of spheres containing it)
+  void trivial_arrangement(Sweep &);
+
+  // Handle a normal event site, closing the edges ending there
+  // and breaking adjacencies beforehand (the sweep only meets normal
+  // sites, spheres having circles through the poles being given up)
+  void handle_normal_event_site(Sweep &, const Normal_event_site &);
+  // ...handle it, once done
+  void handle_event_site(Sweep &, const Normal_event_site &);
 
   // Break adjacencies for an event site
-  void break_adjacencies(const Normal_event_site &);
-  void break_adjacencies(const Polar_event_site &);
+  void break_adjacencies(Sweep &, const Normal_event_site &);
+
+  // Initialize event queue, sorting it on a given thread pool (if any)
+  void initialize_E(Sweep &, const Circle_handle_list &, Thread_pool *);
+  // ...on the pool
+  void initialize_E_on_pool(Sweep & sweep, const Circle_handle_list & circles)
+  { initialize_E(sweep, circles, &thread_pool()); }
+
+  // Initialize V-ordering, using the thread pool or not
+  void initialize_V(Sweep &, const Circle_handle_list &, bool);
+
+  // Lazy discovery: push to E the crossing/tangency events between an
+  // arc of V and its upper neighbor, occurring after a given point (if any)
+  void discover_intersections(Sweep &, typename Vorder::iterator,
+      const Circular_arc_point_3 * = 0);
+  // ...and remove them from E, when these arcs stop being adjacent
+  void forget_intersections(Sweep &, typename Vorder::iterator);
+
+  // Arrangement: new vertex, edge or face
+  Vertex_id new_vertex(Sweep &, const Circular_arc_point_3 &);
+  void new_edge(Sweep &, const Circle_handle &, Vertex_id, Vertex_id,
+      Face_id, Face_id);
+  Face_id new_face(Sweep &, int);
+  // ...add the areas of the faces at the poles, up to a given theta
+  void sweep_poles(Sweep &, double);
+  // ...add the vertex of an event site, and the edges
+  // ending there (before breaking adjacencies)
+  void close_edges(Sweep &, const Normal_event_site &);
+  // ...give faces to the gaps between the arcs of V in a range,
+  // once the arcs are put back after an event site
+  void open_faces(Sweep &, typename Vorder::iterator,
+      typename Vorder::iterator);
+  // ...add the edges of the arcs left in V at the end of the sweep,
+  // ending where they started, on M0
+  void end_arrangement(Sweep &);
+  // ...merge the virtual faces being parts of a same face
+  void merge_faces(Sweep &);
+  // ...give the total area of the faces of each depth
+  void total_areas(Sweep &);
+  // ...depth change when crossing an arc of a circle upwards, the arc
+  // being the lower/upper one for a normal circle
+  int depth_delta(const Sweep &, const Circle_handle &, bool) const;
+
+  // Spheres to sweep, along with their estimated cost (circle count)
+  typedef std::pair<std::size_t, Sphere_handle> Sweep_task;
+  // ...dealt to each worker, costliest first
+  struct Sweep_task_queue
+  {
+    boost::mutex mutex;
+    std::deque<Sweep_task> tasks;
+  };
 
-  // Initialize event queue
-  void initialize_E(const Sphere_handle &, const Circle_handle_list &);
+  // Sweep the tasks of a worker, stealing those of
+  // the other workers once done with its own ones
+  // (or until stopped, giving the worker's status)
+  void run_worker(Sweep_task_queue *, unsigned int, unsigned int,
+      const Run_options *, Run_status *);
 
-  // Initialize V-ordering
-  void initialize_V(const Sphere_handle &, const Circle_handle_list &);
+  // Statistics of a range of spheres (counting-only mode)
+  void statistics_for_range(const std::vector<Sphere_handle> *,
+      std::vector<Diagram_statistics> *, std::size_t, std::size_t) const;
 
-  // Structure used for ordering intersected arcs by a certain point
-  // in the initalization of the V structure
+  // Arc intersected by the initial meridian, along with the intersection
+  // point and its z range, used for ordering the initial V structure
   struct Intersected_arc
+  {
+    Intersected_arc(const Circular_arc_point_3 & p, V_arc * a):
+      point(p), z_min(p.bbox().zmin()), z_max(p.bbox().zmax()), arc(a) {}
+
+    Circular_arc_point_3 point;
+    double z_min, z_max;
+    V_arc * arc;
+  };
+  typedef std::vector<Intersected_arc> Intersected_arcs;
+
+  // Order of intersected arcs: as all the points lie on the initial
+  // meridian, disjoint z ranges decide, and exact comparisons are only
+  // done otherwise
+  struct Compare_intersected_arcs
   {
     typedef typename SK::Compare_theta_z_3 Compare_theta_z_3;
 
-    Intersected_arc(const Sphere_3 & s,
-        const Circular_arc_point_3 & p,
-        const Circular_arc_3 & arc):
-      sphere(s), point(p), arc(arc) {}
+    Compare_intersected_arcs(const Sphere_3 & s):
+      compare(s) {}
 
-    bool operator<(const Intersected_arc & c) const
+    bool operator()(const Intersected_arc & a1, const Intersected_arc & a2) const
     {
-      CGAL_assertion(&sphere == &c.sphere && sphere == c.sphere);
-      return Compare_theta_z_3(sphere)(point, c.point) == CGAL::SMALLER;
+      if (a1.z_max < a2.z_min)
+      { return true; }
+      if (a2.z_max < a1.z_min)
+      { return false; }
+      return compare(a1.point, a2.point) == CGAL::SMALLER;
     }
 
-    const Sphere_3 & sphere;
-    Circular_arc_point_3 point;
-    Circular_arc_3 arc;
+    Compare_theta_z_3 compare;
   };
 
+  // Intersect a range of circles with the initial meridian, adding
+  // their (newly allocated) arcs crossing it to a list
+  void intersect_initial_meridian(const Sweep &,
+      typename Circle_handle_list::const_iterator,
+      typename Circle_handle_list::const_iterator,
+      Intersected_arcs *);
+
+  // Arrangement: add the vertices, faces and depths of the
+  // initial V-ordering, given its sorted arcs
+  void begin_arrangement(Sweep &, const Circle_handle_list &,
+      const Intersected_arcs &);
+
+  public:
+    // Discovery of crossing/tangency events: either all computed up
+    // front (eager), or only between arcs becoming adjacent in the
+    // V-ordering during the sweep (lazy)
+    enum Discovery_mode {
+      Eager, Lazy
+    };
+
+  private:
   // Sphere intersecter
   SI _SI;
-  Vorder _V;
-  EQ _E;
-  Circular_arc_3 _M0;
+
+  // Event queues of previous runs
+  Event_queue_cache<SK> _E_cache;
+
+  // Spheres whose diagram was computed by previous runs
+  Diagram_cache<SK> _diagrams;
+
+  // Discovery of crossing/tangency events
+  Discovery_mode _mode;
+
+  // Choice of the sweep frame of each sphere, and frames chosen
+  // by previous runs
+  bool _choose_frames;
+  Chosen_frames _frames;
+  boost::mutex _frames_mutex;
+
+  // Thread pool running the sweeps, either given or owned
+  Thread_pool * _pool;
+  boost::scoped_ptr<Thread_pool> _own_pool;
+
+  // Output of the arrangements (if any)
+  Sink * _sink;
 
   public:
-    BO_algorithm_for_spheres():
-      _SI(), _V(), _E(), _M0() {}
+    BO_algorithm_for_spheres(Discovery_mode mode = Eager):
+      _SI(), _E_cache(), _diagrams(), _mode(mode), _choose_frames(true),
+      _frames(), _frames_mutex(), _pool(0), _own_pool(), _sink(0) {}
     template <typename InputIterator>
-    BO_algorithm_for_spheres(InputIterator begin, InputIterator end):
-      _SI(begin, end), _V(), _E(), _M0() {}
+    BO_algorithm_for_spheres(InputIterator begin, InputIterator end,
+        Discovery_mode mode = Eager):
+      _SI(begin, end), _E_cache(), _diagrams(), _mode(mode), _choose_frames(true),
+      _frames(), _frames_mutex(), _pool(0), _own_pool(), _sink(0) {}
+
+    // Discovery mode of crossing/tangency events
+    Discovery_mode discovery_mode() const
+    { return _mode; }
+    void set_discovery_mode(Discovery_mode mode)
+    { _mode = mode; }
+
+    // Choice of the frame each sphere is swept in (see Sweep_frame),
+    // rather than always sweeping in the input frame (on by default);
+    // arrangements are given back in the input frame either way.
+    // Without it, spheres having polar/bipolar circles in the input
+    // frame are degenerate.
+    bool sweep_frame_choice() const
+    { return _choose_frames; }
+    void set_sweep_frame_choice(bool choose)
+    { _choose_frames = choose; }
+
+    // Thread pool used for running the sweeps, reused across runs
+    // (by default, a pool with as many threads as hardware threads,
+    // created on first use)
+    Thread_pool & thread_pool()
+    { if (_pool == 0)
+      { _own_pool.reset(new Thread_pool());
+        _pool = _own_pool.get(); }
+      return *_pool; }
+    // ...use a given pool instead, which must outlive the algorithm
+    void set_thread_pool(Thread_pool & pool)
+    { _pool = &pool;
+      _own_pool.reset(); }
+
+    // Sink receiving the arrangements while spheres are swept (none by
+    // default), which must be thread-safe when sweeping many spheres
+    Sink * arrangement_sink() const
+    { return _sink; }
+    void set_arrangement_sink(Sink * sink)
+    { _sink = sink; }
 
     // Add a single sphere
     Sphere_handle add_sphere(const Sphere_3 & sphere)
@@ -114,8 +542,62 @@ class BO_algorithm_for_spheres
     void add_sphere(InputIterator begin, InputIterator end)
     { std::copy(begin, end, _SI.insert_iterator()); }
 
-    void run_for(const Sphere_3 &);
-    void run_for(const Sphere_handle &);
+    // Remove a sphere, its arrangement being dropped from the sink
+    // (the diagrams of the spheres it intersected become dirty)
+    bool remove_sphere(const Sphere_handle &);
+
+    // Check if the diagram of a sphere is dirty, that is if the sphere
+    // was never swept, or if it has been intersected by added/removed
+    // spheres since
+    bool is_dirty(const Sphere_handle & sh) const
+    { return _diagrams.is_dirty(_SI, sh); }
+
+    // Total area of the faces of each depth of a sphere (approximated),
+    // as computed by the last run sweeping it, with or without any
+    // arrangement sink (false if its diagram is dirty)
+    bool depth_areas(const Sphere_handle & sh, Depth_areas & areas) const
+    { return _diagrams.depth_areas(_SI, sh, areas); }
+
+    // Run for a single sphere (or sphere handle)
+    Run_status run_for(const Sphere_3 &, const Run_options & = Run_options());
+    Run_status run_for(const Sphere_handle &, const Run_options & = Run_options());
+
+    // Run for many spheres (or sphere handles) at once, concurrently
+    // sweeping them on the thread pool. The sweeps share reference counted
+    // CGAL objects, which requires a thread safe CGAL (without
+    // CGAL_HAS_NO_THREADS, as checked by the build).
+    template <typename InputIterator>
+    Run_status run_for(InputIterator begin, InputIterator end,
+        const Run_options & options = Run_options())
+    {
+      std::vector<Sphere_handle> spheres;
+      for (; begin != end; begin++)
+      { spheres.push_back(sphere_handle(*begin)); }
+      return run_for_all(spheres, options);
+    }
+    // ...or for all the spheres
+    Run_status run_for_all(const Run_options & options = Run_options())
+    { typename SI::Sphere_iterator_range spheres = _SI.spheres();
+      return run_for(spheres.begin(), spheres.end(), options); }
+    // ...or for a list of sphere handles
+    Run_status run_for_all(const std::vector<Sphere_handle> &,
+        const Run_options & = Run_options());
+    // ...or only for the spheres whose diagram is dirty
+    Run_status run_for_dirty(const Run_options & = Run_options());
+
+    // Counting-only mode: statistics of the arrangement of a sphere (see
+    // Diagram_statistics), without any sweep
+    Diagram_statistics statistics_for(const Sphere_handle & sh) const
+    { return Diagram_statistics_builder<SK>()(_SI, sh); }
+    // ...for many spheres, concurrently on the thread pool
+    void statistics_for_all(const std::vector<Sphere_handle> &,
+        std::vector<Diagram_statistics> &);
+
+  private:
+    // Handle of a sphere, added if needed
+    Sphere_handle sphere_handle(const Sphere_3 &);
+    Sphere_handle sphere_handle(const Sphere_handle & sh)
+    { return sh; }
 };
 
 #endif // BO_ALGORITHM_FOR_SPHERES_H // vim: ft=cpp et sw=2 sts=2
@@ -0,0 +1,30 @@
+#ifndef CANCELLATION_TOKEN_H
+#define CANCELLATION_TOKEN_H
+
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+
+// Flag for cancelling a running computation from another thread (e.g. a
+// UI): the computation polls it, and stops as soon as it sees it set
+class Cancellation_token: boost::noncopyable
+{
+  public:
+    Cancellation_token():
+      _cancelled(false) {}
+
+    // Request cancellation
+    void cancel()
+    { _cancelled.store(true, boost::memory_order_relaxed); }
+
+    bool is_cancelled() const
+    { return _cancelled.load(boost::memory_order_relaxed); }
+
+    // Clear the request, for reusing the token
+    void reset()
+    { _cancelled.store(false, boost::memory_order_relaxed); }
+
+  private:
+    boost::atomic<bool> _cancelled;
+};
+
+#endif // CANCELLATION_TOKEN_H // vim: ft=cpp et sw=2 sts=2
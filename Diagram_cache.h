@@ -0,0 +1,94 @@
+#ifndef DIAGRAM_CACHE_H
+#define DIAGRAM_CACHE_H
+
+#include <map>
+
+#include <boost/thread/mutex.hpp>
+
+#include <Sphere_intersecter.h>
+
+// Record of the spheres of a sphere intersecter whose diagram (the
+// arrangement of their circles) was computed, and is still up to date.
+//
+// Adding or removing a sphere only changes the circles of the spheres it
+// intersects, which get a new stamp (see Sphere_intersecter::stamp): a
+// diagram is then dirty once the sphere's stamp differs from the one it
+// was computed for, and only the dirty diagrams need to be recomputed.
+// A cache is meant to be used with a single sphere intersecter (clear it
+// before switching).
+//
+// Along with each diagram, the total area of its faces of each depth is
+// kept. Diagrams of different spheres can be recorded concurrently.
+template <typename SK>
+class Diagram_cache
+{
+  // Sphere intersecter
+  typedef Sphere_intersecter<SK> SI;
+  typedef typename SI::Sphere_handle Sphere_handle;
+  typedef typename SI::Stamp Stamp;
+
+  public:
+    // Total area of the faces of each depth
+    typedef std::map<int, double> Depth_areas;
+
+  private:
+  // Stamp each diagram was computed for, and its areas
+  struct Entry
+  {
+    Entry():
+      stamp(0), areas() {}
+
+    Stamp stamp;
+    Depth_areas areas;
+  };
+  typedef std::map<Sphere_handle, Entry> Entries;
+
+  public:
+    Diagram_cache():
+      _si(0), _entries(), _mutex() {}
+
+    // Record the diagram of a sphere, computed for a given stamp,
+    // along with its areas
+    void set_computed(const SI &, const Sphere_handle &, Stamp,
+        const Depth_areas &);
+
+    // Check if a sphere's diagram is dirty (never computed, or out
+    // of date)
+    bool is_dirty(const SI &, const Sphere_handle &) const;
+
+    // Get the areas of a sphere's diagram, false if it's dirty
+    bool depth_areas(const SI &, const Sphere_handle &, Depth_areas &) const;
+
+    // Get the spheres of the intersecter whose diagram is dirty
+    template <typename OutputIterator>
+    OutputIterator dirty_spheres(const SI & si, OutputIterator out_it) const
+    {
+      typename SI::Sphere_iterator_range spheres = si.spheres();
+      for (typename SI::Sphere_iterator it = spheres.begin();
+          it != spheres.end(); it++)
+      { if (is_dirty(si, *it))
+        { *out_it++ = *it; } }
+      return out_it;
+    }
+
+    // Forget the diagram of a sphere (e.g. removed from the intersecter)
+    void forget(const Sphere_handle &);
+
+    // Forget the diagrams which aren't up to date anymore
+    void purge(const SI &);
+
+    void clear()
+    { boost::mutex::scoped_lock lock(_mutex);
+      _si = 0; _entries.clear(); }
+
+    std::size_t size() const
+    { boost::mutex::scoped_lock lock(_mutex);
+      return _entries.size(); }
+
+  private:
+    const SI * _si;
+    Entries _entries;
+    mutable boost::mutex _mutex;
+};
+
+#endif // DIAGRAM_CACHE_H // vim: ft=cpp et sw=2 sts=2
@@ -0,0 +1,44 @@
+#ifndef DIAGRAM_STATISTICS_H
+#define DIAGRAM_STATISTICS_H
+
+#include <cstddef>
+
+#include <Sphere_intersecter.h>
+
+// Counts describing the arrangement of the circles on a sphere, got
+// without sweeping it: only its circles are classified and intersected.
+//
+// The arrangement counted is the actual one (without the vertices and
+// faces the sweep adds): its vertices are the distinct intersection
+// points, a circle without any of them being closed by a vertex of its
+// own, and the number of faces follows from Euler's formula for planar
+// graphs, V - E + F = 1 + C, C being the number of connected components
+// of the union of the circles. Coincident circles (see
+// Sphere_intersecter::circles_on_sphere) are counted apart, as the sweep
+// does: they don't meet, and bound an empty face.
+struct Diagram_statistics
+{
+  Diagram_statistics():
+    vertices(0), edges(0), faces(1), components(0),
+    crossings(0), tangencies(0), normal_circles(0),
+    threaded_circles(0), polar_circles(0), bipolar_circles(0) {}
+
+  std::size_t vertices, edges, faces, components;
+
+  // Crossing/tangency points between pairs of circles (two circles
+  // crossing at two points)
+  std::size_t crossings, tangencies;
+
+  // Circles by type
+  std::size_t normal_circles, threaded_circles;
+  std::size_t polar_circles, bipolar_circles;
+};
+
+template <typename SK>
+struct Diagram_statistics_builder
+{
+  Diagram_statistics operator()(const Sphere_intersecter<SK> &,
+      typename Sphere_intersecter<SK>::Sphere_handle const &) const;
+};
+
+#endif // DIAGRAM_STATISTICS_H // vim: ft=cpp et sw=2 sts=2
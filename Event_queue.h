@@ -1,13 +1,16 @@
 #ifndef EVENT_QUEUE_H
 #define EVENT_QUEUE_H
 
-#include <set>
-#include <queue>
+#include <deque>
 #include <vector>
 #include <utility>
+#include <algorithm>
 
 #include <CGAL/assertions.h>
 
+#include <boost/container/small_vector.hpp>
+
+#include <Thread_pool.h>
 #include <Spherical_utils.h>
 #include <Sphere_intersecter.h>
 
@@ -88,7 +91,12 @@ class Event_bundle
     // Intersection normal events are defined by:
     //  - a tag { Smallest_crossing, Largest_crossing, Tangency }
     //  - the pair of circles intersecting
-    struct Intersection_event: Sphere_event
+    //
+    // These only exist within a normal event site, which holds the
+    // point and sphere once for all its events (a crossing point
+    // yields two events, and is shared by the crossing circles),
+    // so they are kept as small as possible.
+    struct Intersection_event
     {
       typedef std::pair<Circle_handle, Circle_handle> Circle_handle_pair;
 
@@ -98,12 +106,14 @@ class Event_bundle
         Tangency
       };
 
-      Intersection_type type;
       Circle_handle_pair circles;
-      Circular_arc_point_3 point;
+      unsigned char type;
+
+      Intersection_type intersection_type() const
+      { return static_cast<Intersection_type>(type); }
 
       bool operator==(const Intersection_event & ev) const
-      { return type == ev.type && circles == ev.circles && point == ev.point; }
+      { return type == ev.type && circles == ev.circles; }
     };
 
     // Polar events are defined by:
@@ -167,16 +177,15 @@ class Event_bundle
         { return Circle_event_builder(c, _sphere); }
 
         // Build an intersection event, passing the
-        // two circles in intersection
+        // two circles in intersection (the point being
+        // held by the normal event site receiving it)
         Intersection_event intersection_event(const Circle_handle & first, const Circle_handle & second,
-            const Circular_arc_point_3 & point, typename Intersection_event::Intersection_type type) const
+            typename Intersection_event::Intersection_type type) const
         {
           Intersection_event ie;
-          link_to_sphere(ie);
           typedef typename Intersection_event::Circle_handle_pair Circle_handle_pair;
           ie.circles = Circle_handle_pair(first, second);
-          ie.type = type;
-          ie.point = point;
+          ie.type = static_cast<unsigned char>(type);
           return ie;
         }
 
@@ -251,9 +260,10 @@ class Event_bundle
       friend class Intersection_events_range;
 
       public:
-        // Start/End events
-        typedef std::multiset<Critical_event, Comp_event_circle_radii> Start_events;
-        typedef std::multiset<Critical_event, Comp_event_inv_circle_radii> End_events;
+        // Start/End events, kept inline as most sites only hold one or
+        // two of them, and sorted by radii once the site is finalized
+        typedef boost::container::small_vector<Critical_event, 2> Start_events;
+        typedef boost::container::small_vector<Critical_event, 2> End_events;
 
         // Crossing/Tangency events
         typedef std::vector<Intersection_event> Intersection_events;
@@ -270,6 +280,18 @@ class Event_bundle
         // Overload for adding an intersection event
         void add_event(const Intersection_event &);
 
+        // Sort the start events by increasing radii, and the end events
+        // by decreasing radii, once all the events have been added
+        void finalize();
+
+        // Add all the events of another site, located at the same point,
+        // both sites being finalized
+        void merge(const Normal_event_site &);
+
+        // Exchange the content of two sites, allowing to move
+        // sites around without copying their events
+        void swap(Normal_event_site &);
+
         // Done using lexicographic comparing. This introduces
         // the concepts that points are compared lexicographically and are
         // placed in a frame local to the sphere (ie with its origin at the
@@ -434,84 +456,206 @@ class Event_queue
       None, Normal, Polar, Bipolar
     };
 
-    // Wrapper for any event site in the queue
-    class Any_event_site
+    // Ordering of the queued sites:
+    //  - a heap, allowing sites to be pushed at any time
+    //  - a schedule sorted once, meant for sites all known up front
+    //    (pushing afterwards needs a linear insertion)
+    //  - buckets of sites by approximate theta, sites only being compared
+    //    exactly within a bucket (and with the sites that can't be
+    //    bucketed: polar/bipolar sites, sites close to the poles or to
+    //    the meridian at theta == 0)
+    enum Ordering {
+      Dynamic_heap, Static_schedule, Theta_buckets
+    };
+
+    // Identifier of a site in the queue, made of its type
+    // and of its index among the sites of this type
+    struct Site_id
     {
-      public:
-        Any_event_site():
-          _impl(0, None) {}
-        Any_event_site(const Normal_event_site & nes):
-          _impl(new Normal_event_site(nes), Normal) {}
-        Any_event_site(const Polar_event_site & pes):
-          _impl(new Polar_event_site(pes), Polar) {}
-        Any_event_site(const Bipolar_event_site & bpes):
-          _impl(new Bipolar_event_site(bpes), Bipolar) {}
-
-        Any_event_site(const Any_event_site & aes);
-
-        ~Any_event_site();
-        Any_event_site & operator=(const Any_event_site &);
-
-        // Get the underlying type
-        Event_site_type type() const
-        { CGAL_assertion(_impl.second != None);
-          return _impl.second; }
-
-        // Conversion methods, check assertions in debug mode
-        const Normal_event_site & as_normal() const
-        { CGAL_assertion(_impl.second == Normal);
-          return *static_cast<const Normal_event_site *>(_impl.first); }
-        const Polar_event_site & as_polar() const
-        { CGAL_assertion(_impl.second == Polar);
-          return *static_cast<const Polar_event_site *>(_impl.first); }
-        const Bipolar_event_site & as_bipolar() const
-        { CGAL_assertion(_impl.second == Bipolar);
-          return *static_cast<const Bipolar_event_site *>(_impl.first); }
-
-        bool operator<(const Any_event_site & e) const;
-        bool operator<(const Normal_event_site & nes) const;
-        bool operator<(const Polar_event_site & pes) const;
-        bool operator<(const Bipolar_event_site & bpes) const;
+      Site_id():
+        type(None), index(0) {}
+      Site_id(Event_site_type t, std::size_t i):
+        type(t), index(i) {}
+
+      bool operator==(const Site_id & id) const
+      { return type == id.type && index == id.index; }
+      bool operator!=(const Site_id & id) const
+      { return !(*this == id); }
+
+      Event_site_type type;
+      std::size_t index;
+    };
+
+  private:
+    // Sites are stored once in an arena (one per type of site), never
+    // moved while queued, only their ids being ordered in the heap.
+    // Deques never copy their elements when growing.
+    typedef std::deque<Normal_event_site> Normal_event_sites;
+    typedef std::deque<Polar_event_site> Polar_event_sites;
+    typedef std::deque<Bipolar_event_site> Bipolar_event_sites;
+
+    // Access a site of the arena by index, the type of the
+    // site being given by the (unused) pointer argument
+    const Normal_event_site & site(std::size_t i, const Normal_event_site *) const
+    { return _normal_sites[i]; }
+    const Polar_event_site & site(std::size_t i, const Polar_event_site *) const
+    { return _pe_sites[i]; }
+    const Bipolar_event_site & site(std::size_t i, const Bipolar_event_site *) const
+    { return _bpe_sites[i]; }
+
+    // Compare two sites whose types are known at compile time
+    template <typename Left, typename Right>
+    static bool occurs_before(const Event_queue & eq,
+        std::size_t left, std::size_t right)
+    { return eq.site(left, static_cast<const Left *>(0))
+        .occurs_before(eq.site(right, static_cast<const Right *>(0))); }
+
+    // Comparison for each pair of site types (indexed by Event_site_type)
+    typedef bool (*Site_comparison)(const Event_queue &, std::size_t, std::size_t);
+    static const Site_comparison site_comparisons[4][4];
+
+    // Compare two queued sites, normal sites (the vast majority)
+    // being compared directly, and other sites through the table
+    bool occurs_before(const Site_id & left, const Site_id & right) const
+    { CGAL_assertion(left.type != None && right.type != None);
+      if (left.type == Normal && right.type == Normal)
+      { return _normal_sites[left.index].occurs_before(_normal_sites[right.index]); }
+      return site_comparisons[left.type][right.type](*this, left.index, right.index); }
+
+    // Compare two normal sites, as a function object
+    struct Normal_occurs_before
+    {
+      Normal_occurs_before(const Event_queue & eq):
+        _eq(eq) {}
+
+      bool operator()(const Site_id & left, const Site_id & right) const
+      { CGAL_assertion(left.type == Normal && right.type == Normal);
+        return _eq._normal_sites[left.index].occurs_before(
+            _eq._normal_sites[right.index]); }
 
       private:
-        std::pair<void *, Event_site_type> _impl;
+        const Event_queue & _eq;
     };
 
-  private:
-    // Actual queue implementation
-    typedef std::priority_queue<Any_event_site> Event_site_queue;
+    // Check if a site is a normal site
+    static bool is_normal(const Site_id & id)
+    { return id.type == Normal; }
+
+    // Same, as a function object (for sorting)
+    struct Occurs_before
+    {
+      Occurs_before(const Event_queue & eq):
+        _eq(eq) {}
+
+      bool operator()(const Site_id & left, const Site_id & right) const
+      { return _eq.occurs_before(left, right); }
+
+      private:
+        const Event_queue & _eq;
+    };
+
+    // ...inverse (for standard heaps)
+    struct Occurs_after
+    {
+      Occurs_after(const Event_queue & eq):
+        _eq(eq) {}
+
+      bool operator()(const Site_id & left, const Site_id & right) const
+      { return _eq.occurs_before(right, left); }
+
+      private:
+        const Event_queue & _eq;
+    };
+
+    // Actual queue implementation: array of site ids, either organized as
+    // an indexed 4-ary heap or sorted (static schedule). The position in
+    // the array of each stored site is kept, so that any site can be
+    // located (and removed) from its id.
+    //
+    // With theta buckets, this array is a (standard) heap of the sites
+    // which can't be bucketed, and the positions of sites are only used
+    // to know if they're still queued.
+    typedef std::vector<Site_id> Event_site_queue;
+    typedef std::vector<std::size_t> Heap_positions;
+    static const std::size_t Arity = 4;
+    static const std::size_t Not_queued = static_cast<std::size_t>(-1);
+    static const std::size_t Queued = 0;
+
+    // Theta buckets (standard heaps), and whether each normal site
+    // possibly lies in the bucket following its own
+    typedef std::vector<Event_site_queue> Theta_buckets_type;
+    typedef std::vector<char> Straddling_flags;
 
   public:
+    // Handle to a site of the queue, valid until the queue is cleared
+    typedef Site_id Site_handle;
+    typedef std::vector<Site_handle> Site_handles;
+
     // STL container concept requirements (delegation)
     typedef typename Event_site_queue::value_type value_type;
     typedef typename Event_site_queue::reference reference;
     typedef typename Event_site_queue::const_reference const_reference;
     typedef typename Event_site_queue::size_type size_type;
 
+    Event_queue():
+      _ordering(Dynamic_heap),
+      _queue(), _cursor(0), _removed(0),
+      _buckets(), _bucket_width(0), _bucketed(0),
+      _current(0), _straddling(), _front(), _front_bucket(0),
+      _normal_sites(), _pe_sites(), _bpe_sites() {}
+
     bool empty() const
-    { return _queue.empty(); }
+    { return size() == 0; }
 
     size_type size() const
-    { return _queue.size(); }
+    { return _queue.size() + _bucketed - _cursor - _removed; }
+
+    void clear();
+
+    // Exchange the content of two queues (without copying their sites)
+    void swap(Event_queue &);
 
-    void clear()
-    { _queue = Event_site_queue(); }
+    // Current ordering
+    Ordering ordering() const
+    { return _ordering; }
+
+    // Change the ordering, reordering the queued sites. The static
+    // schedule is sorted on the given thread pool, if any.
+    void set_ordering(Ordering, Thread_pool * = 0);
 
     // Push normal events to the queue
-    void push(const Normal_event_site & nes)
-    { _queue.push(nes); }
+    Site_handle push(const Normal_event_site & nes)
+    { _normal_sites.push_back(nes);
+      return push_id(Site_id(Normal, _normal_sites.size() - 1)); }
     // ...push polar events
-    void push(const Polar_event_site & pes)
-    { _queue.push(pes); }
+    Site_handle push(const Polar_event_site & pes)
+    { _pe_sites.push_back(pes);
+      return push_id(Site_id(Polar, _pe_sites.size() - 1)); }
     // ...push bipolar events
-    void push(const Bipolar_event_site & bpes)
-    { _queue.push(bpes); }
+    Site_handle push(const Bipolar_event_site & bpes)
+    { _bpe_sites.push_back(bpes);
+      return push_id(Site_id(Bipolar, _bpe_sites.size() - 1)); }
+
+    // Push many sites at once, taking over the given normal sites
+    // (which are left empty) and ordering the queue in a single pass.
+    // Handles of the pushed sites are added to the last argument, if any.
+    void take(std::vector<Normal_event_site> &,
+        const std::vector<Polar_event_site> &,
+        const std::vector<Bipolar_event_site> &,
+        Site_handles * = 0);
+
+    // Check if a site is still in the queue (not popped/removed)
+    bool contains(const Site_handle & h) const
+    { return h.type != None && _positions[h.type][h.index] != Not_queued; }
+
+    // Remove a site from the queue, O(log n)
+    void remove(const Site_handle &);
 
     // Type of the next event in the queue
     Event_site_type next_event() const
-    { return empty() == false ? _queue.top().type() : None; }
+    { return empty() == false ? front_id().type : None; }
 
-    // Top/Pop normal
+    // Top/Pop normal (the popped site is moved out of the queue)
     const Normal_event_site & top_normal() const;
     Normal_event_site pop_normal();
 
@@ -523,8 +667,149 @@ class Event_queue
     const Bipolar_event_site & top_bipolar() const;
     Bipolar_event_site pop_bipolar();
 
+    // Walker of a queue in static schedule, reading its sites in place
+    // (popping them from the walker only): a queue scheduled once, such
+    // as a cached one, can be walked any number of times without being
+    // copied or sorted again. The queue must outlive the walker, and
+    // can't be changed meanwhile.
+    class Cursor
+    {
+      public:
+        Cursor():
+          _eq(0), _pos(0), _size(0) {}
+        explicit Cursor(const Event_queue & eq):
+          _eq(&eq), _pos(eq._cursor), _size(eq.size())
+        { CGAL_assertion(eq.ordering() == Static_schedule);
+          skip_removed(); }
+
+        bool empty() const
+        { return _size == 0; }
+
+        size_type size() const
+        { return _size; }
+
+        Event_site_type next_event() const
+        { return empty() == false ? _eq->_queue[_pos].type : None; }
+
+        const Normal_event_site & top_normal() const
+        { CGAL_assertion(next_event() == Normal);
+          return _eq->_normal_sites[_eq->_queue[_pos].index]; }
+        const Normal_event_site & pop_normal()
+        { const Normal_event_site & nes = top_normal();
+          pop();
+          return nes; }
+
+        const Polar_event_site & top_polar() const
+        { CGAL_assertion(next_event() == Polar);
+          return _eq->_pe_sites[_eq->_queue[_pos].index]; }
+        const Polar_event_site & pop_polar()
+        { const Polar_event_site & pes = top_polar();
+          pop();
+          return pes; }
+
+        const Bipolar_event_site & top_bipolar() const
+        { CGAL_assertion(next_event() == Bipolar);
+          return _eq->_bpe_sites[_eq->_queue[_pos].index]; }
+        const Bipolar_event_site & pop_bipolar()
+        { const Bipolar_event_site & bpes = top_bipolar();
+          pop();
+          return bpes; }
+
+      private:
+        void pop()
+        { _pos++;
+          _size--;
+          skip_removed(); }
+
+        // Skip the sites removed from the queue
+        void skip_removed()
+        { while (_size != 0 && _eq->_positions[_eq->_queue[_pos].type]
+              [_eq->_queue[_pos].index] == Not_queued)
+          { _pos++; } }
+
+        const Event_queue * _eq;
+        std::size_t _pos;
+        size_type _size;
+    };
+
   private:
+    // Id of the next site
+    const Site_id & front_id() const
+    { return (_ordering == Theta_buckets) ? _front : _queue[_cursor]; }
+
+    // Heap position of a stored site
+    std::size_t & position(const Site_id & id)
+    { return _positions[id.type][id.index]; }
+
+    // Put a site id at a given heap position
+    void place(std::size_t pos, const Site_id & id)
+    { _queue[pos] = id;
+      position(id) = pos; }
+
+    // Restore heap order around a position
+    void sift_up(std::size_t);
+    void sift_down(std::size_t);
+
+    // Add the id of a newly stored site to the queue
+    Site_handle push_id(const Site_id &);
+
+    // Remove the next id from the queue, returning it
+    Site_id pop_id();
+
+    // Remove the id at a given heap position, returning it
+    Site_id remove_at(std::size_t);
+
+    // Static schedule helpers: sort ids (the normal ones apart, possibly
+    // in parallel), sort the ids appended from a given position, and skip
+    // removed ids
+    void sort_ids(typename Event_site_queue::iterator,
+        typename Event_site_queue::iterator, Thread_pool *);
+    void sort_normal_ids(typename Event_site_queue::iterator,
+        typename Event_site_queue::iterator, Thread_pool *);
+    static void sort_normal_range(const Event_queue *,
+        typename Event_site_queue::iterator,
+        typename Event_site_queue::iterator);
+    void schedule(std::size_t, Thread_pool *);
+    void skip_removed();
+
+    // Theta buckets helpers: compute a certified interval of theta
+    // for a normal site (false if it can't be bucketed), setup buckets
+    // for a number of sites, add an id, and find the next site
+    bool theta_interval(const Normal_event_site &, double &, double &) const;
+    void setup_buckets(std::size_t);
+    void insert_bucketed(const Site_id &);
+    void drop_removed(Event_site_queue &, bool);
+    void settle();
+
+    // Enqueue the ids of newly stored sites (sorting them
+    // on the given thread pool, if any)
+    void enqueue(const Event_site_queue &, Thread_pool * = 0);
+
+    // Ordering
+    Ordering _ordering;
+
+    // Ordered ids. In static schedule, sites before the cursor were
+    // already popped, and removed sites are left in place (and counted).
     Event_site_queue _queue;
+    std::size_t _cursor;
+    std::size_t _removed;
+
+    // Theta buckets, by increasing theta, starting from the current one.
+    // The front site is kept, along with its bucket (the number of
+    // buckets for the fallback heap).
+    Theta_buckets_type _buckets;
+    double _bucket_width;
+    std::size_t _bucketed;
+    std::size_t _current;
+    Straddling_flags _straddling;
+    Site_id _front;
+    std::size_t _front_bucket;
+
+    // Arena, and heap positions of its sites (by site type)
+    Normal_event_sites _normal_sites;
+    Polar_event_sites _pe_sites;
+    Bipolar_event_sites _bpe_sites;
+    Heap_positions _positions[4];
 };
 
 #endif // EVENT_QUEUE_H // vim: ft=cpp et sw=2 sts=2
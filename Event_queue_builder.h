@@ -1,9 +1,146 @@
 #ifndef EVENT_QUEUE_BUILDER_H
 #define EVENT_QUEUE_BUILDER_H
 
+#include <map>
+#include <vector>
+#include <cmath>
+#include <limits>
+
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_map.hpp>
+
 #include <Event_queue.h>
 #include <Sphere_intersecter.h>
 
+// Normal event sites of a sphere, grouped by point.
+//
+// Sites are stored in a vector, and indexed on a regular grid by the
+// bounding box of their point: as the box of a point always contains
+// the exact point, two equal points always share a grid cell, so that
+// exact comparisons are only done between points of the same cells.
+template <typename SK>
+class Normal_event_site_map
+{
+  // Geometrical objects
+  typedef typename SK::Circular_arc_point_3 Circular_arc_point_3;
+  typedef typename SK::Sphere_3 Sphere_3;
+
+  // Sphere intersecter and event sites
+  typedef typename Sphere_intersecter<SK>::Sphere_handle Sphere_handle;
+  typedef typename Event_bundle<SK>::Normal_event_site Normal_event_site;
+
+  // Grid cell (integer coordinates)
+  struct Grid_cell
+  {
+    Grid_cell(long x_, long y_, long z_):
+      x(x_), y(y_), z(z_) {}
+
+    bool operator==(const Grid_cell & gc) const
+    { return x == gc.x && y == gc.y && z == gc.z; }
+
+    friend std::size_t hash_value(const Grid_cell & gc)
+    { std::size_t seed = 0;
+      boost::hash_combine(seed, gc.x);
+      boost::hash_combine(seed, gc.y);
+      boost::hash_combine(seed, gc.z);
+      return seed; }
+
+    long x, y, z;
+  };
+
+  // Grid cells, mapped to the indices of their sites
+  typedef boost::unordered_multimap<Grid_cell, std::size_t> Grid;
+
+  public:
+    typedef std::vector<Normal_event_site> Sites;
+
+    Normal_event_site_map(const Sphere_handle &);
+
+    // Get the site located at a point, creating it if needed
+    Normal_event_site & operator[](const Circular_arc_point_3 &);
+
+    // Access the sites (in no particular order)
+    Sites & sites()
+    { return _sites; }
+    const Sites & sites() const
+    { return _sites; }
+
+  private:
+    // Cell coordinate along an axis (rounding being monotonic,
+    // a range of values maps to a range of cells)
+    long cell_coordinate(double v, int axis) const
+    { return static_cast<long>(std::floor((v - _center[axis]) / _cell_size)); }
+
+    Sphere_handle _sphere;
+    double _center[3];
+    double _cell_size;
+    Grid _grid;
+    Sites _sites;
+};
+
+// Gathers all the events lying on a single sphere, regrouping normal
+// events in their event sites, before handing them to an event queue
+template <typename SK>
+class Event_site_collector
+{
+  // Geometrical objects
+  typedef typename SK::Circular_arc_point_3 Circular_arc_point_3;
+  typedef typename SK::Object_3 Object_3;
+
+  // Sphere intersecter
+  typedef Sphere_intersecter<SK> SI;
+  typedef typename SI::Circle_handle Circle_handle;
+  typedef typename SI::Sphere_handle Sphere_handle;
+
+  // Event sites
+  typedef typename Event_queue<SK>::Events Events;
+  typedef typename Events::Normal_event_site Normal_event_site;
+  typedef typename Events::Polar_event_site Polar_event_site;
+  typedef typename Events::Bipolar_event_site Bipolar_event_site;
+  typedef typename Events::Critical_event Critical_event;
+  typedef typename Events::Intersection_event Intersection_event;
+
+  // Normal event sites, grouped by corresponding point
+  typedef Normal_event_site_map<SK> Normal_event_sites;
+  // ...polar/bipolar event sites
+  typedef std::vector<Polar_event_site> Polar_event_sites;
+  typedef std::vector<Bipolar_event_site> Bipolar_event_sites;
+
+  public:
+    // Result of the intersection of two circles
+    typedef std::vector<Object_3> Intersection_list;
+
+    Event_site_collector(const Sphere_handle & sh):
+      _sphere(sh), _normal_sites(sh),
+      _pe_sites(), _bpe_sites() {}
+
+    // Add the critical/polar/bipolar events of a circle
+    // lying on the collector's sphere
+    void add_circle_events(const Circle_handle &);
+
+    // Add the crossing/tangency events between two circles
+    // lying on the collector's sphere, given their intersection
+    void add_intersection_events(const Circle_handle &,
+        const Circle_handle &, const Intersection_list &);
+
+    // Hand all the collected event sites over to an event queue,
+    // the normal event sites being moved (and thus left empty),
+    // adding the handles of the queued sites to the last argument
+    void fill(Event_queue<SK> &,
+        typename Event_queue<SK>::Site_handles * = 0);
+
+  private:
+    void add_to_normal_site(const Circular_arc_point_3 &,
+        const Critical_event &);
+    void add_to_normal_site(const Circular_arc_point_3 &,
+        const Intersection_event &);
+
+    Sphere_handle _sphere;
+    Normal_event_sites _normal_sites;
+    Polar_event_sites _pe_sites;
+    Bipolar_event_sites _bpe_sites;
+};
+
 template <typename SK>
 struct Event_queue_builder
 {
@@ -13,4 +150,22 @@ struct Event_queue_builder
       typename Sphere_intersecter<SK>::Sphere_handle const &);
 };
 
+// Builds the event queues of all the spheres of a scene at once.
+//
+// A crossing point between the circles S∩A and S∩B on a sphere S is
+// the triple point S∩A∩B, which is also a crossing point on A (between
+// A∩S and A∩B) and on B (between B∩S and B∩A). Each triple of mutually
+// intersecting spheres is thus only handled on its first sphere (by
+// handle order), and the resulting events are routed to all three.
+// Pairs whose third circle doesn't exist are intersected on their own
+// sphere, so that each queue is the one Event_queue_builder gives.
+template <typename SK>
+struct Scene_event_queue_builder
+{
+  typedef std::map<typename Sphere_intersecter<SK>::Sphere_handle,
+          Event_queue<SK> > Event_queue_map;
+
+  Event_queue_map operator()(const Sphere_intersecter<SK> &);
+};
+
 #endif // EVENT_QUEUE_BUILDER_H // vim: ft=cpp et sw=2 sts=2
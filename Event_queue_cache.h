@@ -0,0 +1,84 @@
+#ifndef EVENT_QUEUE_CACHE_H
+#define EVENT_QUEUE_CACHE_H
+
+#include <map>
+#include <vector>
+#include <utility>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <Event_queue.h>
+#include <Event_queue_builder.h>
+#include <Sphere_intersecter.h>
+
+// Cache of the event queues of the spheres of a sphere intersecter.
+//
+// A sphere's event queue only depends on its circles, so a cached queue
+// is kept as long as the sphere's stamp (see Sphere_intersecter::stamp)
+// stays the same, and rebuilt otherwise. A cache is meant to be used
+// with a single sphere intersecter (clear it before switching).
+//
+// Queues are cached in static schedule, sorted once when built, and
+// shared: they're meant to be walked in place (see Event_queue::Cursor),
+// and stay valid as long as they're held, even once replaced.
+//
+// The queues of different spheres can be got concurrently, each being
+// built outside of the cache's lock.
+template <typename SK>
+class Event_queue_cache
+{
+  // Sphere intersecter
+  typedef Sphere_intersecter<SK> SI;
+  typedef typename SI::Sphere_handle Sphere_handle;
+  typedef typename SI::Stamp Stamp;
+
+  public:
+    // Shared (scheduled) event queue
+    typedef boost::shared_ptr<const Event_queue<SK> > Event_queue_ptr;
+
+  private:
+    // Cached event queue, along with the stamp it was built for
+    typedef std::pair<Stamp, Event_queue_ptr> Entry;
+    typedef std::map<Sphere_handle, Entry> Entries;
+
+  public:
+    Event_queue_cache():
+      _si(0), _entries(), _mutex() {}
+
+    // Get the event queue of a sphere, built (and sorted on the given
+    // thread pool, if any) only if needed
+    Event_queue_ptr operator()(const SI &,
+        typename SK::Sphere_3 const &, Thread_pool * = 0);
+    Event_queue_ptr operator()(const SI &,
+        const Sphere_handle &, Thread_pool * = 0);
+
+    // Build the event queues of all the spheres of an intersecter at
+    // once (see Scene_event_queue_builder), only keeping those which
+    // aren't up to date. Cheaper than building them one by one when
+    // most of the spheres are swept, since each triple point is then
+    // computed once instead of once per sphere.
+    void prefill(const SI &);
+
+    // Check if a sphere's cached event queue is up to date
+    bool is_up_to_date(const SI &, const Sphere_handle &) const;
+
+    // Drop the event queues which aren't up to date anymore
+    // (notably those of spheres removed from the intersecter)
+    void purge(const SI &);
+
+    void clear()
+    { boost::mutex::scoped_lock lock(_mutex);
+      _si = 0; _entries.clear(); }
+
+    std::size_t size() const
+    { boost::mutex::scoped_lock lock(_mutex);
+      return _entries.size(); }
+
+  private:
+    const SI * _si;
+    Entries _entries;
+    mutable boost::mutex _mutex;
+};
+
+#endif // EVENT_QUEUE_CACHE_H // vim: ft=cpp et sw=2 sts=2
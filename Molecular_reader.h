@@ -0,0 +1,126 @@
+#ifndef MOLECULAR_READER_H
+#define MOLECULAR_READER_H
+
+#include <map>
+#include <vector>
+#include <string>
+#include <cstddef>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <Sphere_file.h>
+#include <Thread_pool.h>
+
+// Radii of atoms, by element symbol (van der Waals radii of Bondi, in
+// angstroms, by default)
+class Radius_table
+{
+  public:
+    Radius_table();
+
+    // Set the radius of an element
+    void set(const std::string & element, double radius)
+    { _radii[element] = radius; }
+
+    // Radius of an element (the default radius if unknown)
+    double radius(const std::string & element) const
+    { std::map<std::string, double>::const_iterator it = _radii.find(element);
+      return it == _radii.end() ? _default_radius : it->second; }
+
+    void set_default_radius(double radius)
+    { _default_radius = radius; }
+
+  private:
+    std::map<std::string, double> _radii;
+    double _default_radius;
+};
+
+// Reader of the atoms of molecular structure files, as spheres:
+//  - XYZR: "x y z r" per line (as used by MSMS)
+//  - PQR: ATOM/HETATM records, ending with "x y z charge radius"
+//  - PDB: ATOM/HETATM records, the radius of each atom being given by
+//    a radius table, from its element (or the alignment of its name)
+//
+// A file is mapped in memory and split on line boundaries into pieces,
+// parsed in parallel on a thread pool: multi-gigabyte files (e.g. PDB
+// trajectories, with one MODEL per frame) are read at the disk's speed.
+//
+// Atoms are given as sphere records (see Sphere_file.h), along with a
+// side array of their ids (at the same indices), for mapping results
+// back to the atoms. Atoms with a non positive radius are skipped, and
+// atoms with non finite values are malformed.
+class Molecular_reader: boost::noncopyable
+{
+  public:
+    enum Format { XYZR, PQR, PDB };
+
+    // Id of an atom
+    struct Atom_id
+    {
+      boost::uint64_t index; // Index of the atom's line in the file's atoms
+      long serial;           // Serial number (PQR/PDB), or -1
+      int model;             // Model number (PQR/PDB), or 0 without models
+    };
+
+    typedef std::vector<Sphere_record> Records;
+    typedef std::vector<Atom_id> Atom_ids;
+
+    // Sphere iterator (on the records)
+    template <typename SK>
+    struct Sphere_iterator
+    {
+      typedef boost::transform_iterator<Sphere_from_record<SK>,
+              Records::const_iterator> type;
+    };
+
+    explicit Molecular_reader(const Radius_table & radii = Radius_table()):
+      _radii(radii), _records(), _atom_ids(), _skipped(0) {}
+
+    // Format of a file, from its extension (.xyzr, .pqr, or .pdb/.ent),
+    // throwing std::runtime_error when unknown
+    static Format format_of(const std::string &);
+
+    // Read the atoms of a file (replacing the ones read before),
+    // returning their number, and throwing std::runtime_error when the
+    // file can't be read or has a malformed line
+    std::size_t read(const std::string &, Format, Thread_pool &);
+
+    // Atoms, as sphere records (holding radii)
+    const Records & records() const
+    { return _records; }
+
+    // Atoms' ids
+    const Atom_ids & atom_ids() const
+    { return _atom_ids; }
+
+    // Atoms, as spheres, for the bulk loader
+    template <typename SK>
+    typename Sphere_iterator<SK>::type spheres_begin() const
+    { return typename Sphere_iterator<SK>::type(_records.begin(),
+        Sphere_from_record<SK>(true)); }
+    template <typename SK>
+    typename Sphere_iterator<SK>::type spheres_end() const
+    { return typename Sphere_iterator<SK>::type(_records.end(),
+        Sphere_from_record<SK>(true)); }
+
+    std::size_t size() const
+    { return _records.size(); }
+
+    // Number of atoms skipped (for a non positive radius)
+    std::size_t skipped() const
+    { return _skipped; }
+
+  private:
+    struct Piece;
+
+    // Parse a piece of a file
+    void parse(Piece &, Format) const;
+
+    Radius_table _radii;
+    Records _records;
+    Atom_ids _atom_ids;
+    std::size_t _skipped;
+};
+
+#endif // MOLECULAR_READER_H // vim: ft=cpp et sw=2 sts=2
@@ -0,0 +1,234 @@
+#ifndef SPHERE_FILE_H
+#define SPHERE_FILE_H
+
+#include <string>
+#include <fstream>
+#include <istream>
+#include <iterator>
+#include <cstddef>
+#include <cmath>
+
+#include <CGAL/number_utils.h>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/iterator/transform_iterator.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+// Binary sphere files: a fixed header, followed by the spheres as a
+// contiguous array of fixed-size records, so that a file can be mapped
+// in memory and its spheres read in place (without any parsing).
+//
+// Records hold the center's coordinates and the radius (or squared
+// radius) of a sphere as doubles, in the byte order of the machine that
+// wrote the file. Coordinates are exact: doubles are converted to the
+// kernel's number type without any rounding, and spheres whose
+// coordinates aren't doubles are only written when rounding is asked
+// (see Sphere_file_writer).
+struct Sphere_file_header
+{
+  // Kind of the records' last coordinate
+  enum Radius_kind
+  {
+    SQUARED_RADIUS = 0, // the squared radius (as in Sphere_3)
+    RADIUS = 1          // the radius (squared exactly, when read)
+  };
+
+  char magic[8];               // "TDSPHERE"
+  boost::uint32_t version;     // Format version
+  boost::uint32_t byte_order;  // Byte order mark (0x01020304)
+  boost::uint32_t radius_kind; // Radius_kind of the records
+  boost::uint32_t record_size; // Size of a record (in bytes)
+  boost::uint64_t size;        // Number of records
+};
+
+// Record of a sphere, in a sphere file
+struct Sphere_record
+{
+  double x, y, z; // Center
+  double r;       // Radius or squared radius (see the file's header)
+};
+
+BOOST_STATIC_ASSERT(sizeof(Sphere_file_header) == 32);
+BOOST_STATIC_ASSERT(sizeof(Sphere_record) == 32);
+
+// Check if a record is a sphere: a finite center, and a finite
+// positive radius (or squared radius)
+bool is_valid_record(const Sphere_record &);
+
+// Sphere of a sphere file's record
+template <typename SK>
+struct Sphere_from_record
+{
+  typedef typename SK::FT FT;
+  typedef typename SK::Point_3 Point_3;
+  typedef typename SK::Sphere_3 Sphere_3;
+  typedef Sphere_3 result_type;
+
+  Sphere_from_record(bool radius = false):
+    _radius(radius) {}
+
+  Sphere_3 operator()(const Sphere_record & r) const
+  {
+    FT radius(r.r);
+    return Sphere_3(Point_3(r.x, r.y, r.z),
+        _radius ? radius * radius : radius);
+  }
+
+  private:
+    bool _radius;
+};
+
+// Reader of a sphere file, mapping it in memory: its records are read
+// in place, from the mapped file, and converted to spheres on the fly.
+// The spheres can thus be fed to bulk insertion without copying them:
+//
+//   Sphere_file_reader file(filename);
+//   Sphere_intersecter<SK> si(file.spheres_begin<SK>(),
+//                             file.spheres_end<SK>());
+class Sphere_file_reader: boost::noncopyable
+{
+  public:
+    typedef const Sphere_record * Record_iterator;
+
+    // Sphere iterator (on the records)
+    template <typename SK>
+    struct Sphere_iterator
+    {
+      typedef boost::transform_iterator<Sphere_from_record<SK>,
+              Record_iterator> type;
+    };
+
+    // Map a file, throwing std::runtime_error when it can't be read
+    // (or isn't a sphere file, of a known version, or has an invalid
+    // record, see is_valid_record)
+    explicit Sphere_file_reader(const std::string &);
+
+    const Sphere_file_header & header() const
+    { return *_header; }
+
+    // Number of spheres
+    std::size_t size() const
+    { return _header->size; }
+
+    // Records
+    Record_iterator records_begin() const
+    { return _records; }
+    Record_iterator records_end() const
+    { return _records + size(); }
+
+    // Spheres
+    template <typename SK>
+    typename Sphere_iterator<SK>::type spheres_begin() const
+    { return typename Sphere_iterator<SK>::type(records_begin(),
+        Sphere_from_record<SK>(has_radii())); }
+    template <typename SK>
+    typename Sphere_iterator<SK>::type spheres_end() const
+    { return typename Sphere_iterator<SK>::type(records_end(),
+        Sphere_from_record<SK>(has_radii())); }
+
+    // Whether the records hold radii (rather than squared radii)
+    bool has_radii() const
+    { return _header->radius_kind == Sphere_file_header::RADIUS; }
+
+  private:
+    boost::interprocess::file_mapping _file;
+    boost::interprocess::mapped_region _region;
+    const Sphere_file_header * _header;
+    Record_iterator _records;
+};
+
+// Writer of a sphere file, given its spheres one at a time: the file is
+// complete once the writer is closed (or destroyed)
+class Sphere_file_writer: boost::noncopyable
+{
+  public:
+    // Create a file, throwing std::runtime_error when it can't be
+    // (the records holding radii, or squared radii by default)
+    explicit Sphere_file_writer(const std::string &,
+        Sphere_file_header::Radius_kind = Sphere_file_header::SQUARED_RADIUS);
+
+    ~Sphere_file_writer();
+
+    // Check if the squared radius of a sphere is the square of a double
+    // (as for spheres given by their radii, e.g. atoms), so that records
+    // holding radii fit spheres which all pass
+    template <typename Sphere_3>
+    static bool has_exact_radius(const Sphere_3 & s)
+    { double r;
+      return to_exact_radius(s.squared_radius(), r); }
+
+    // Write a record
+    void write(const Sphere_record &);
+
+    // Write a sphere, returning false (and writing nothing) when it can't
+    // be written exactly, its coordinates or its radius (or squared
+    // radius, depending on the records) not being doubles. If asked, it's
+    // rather rounded to the nearest doubles (and false still returned).
+    template <typename Sphere_3>
+    bool write(const Sphere_3 & s, bool round = false)
+    {
+      Sphere_record r;
+      bool exact = to_exact_double(s.center().x(), r.x);
+      exact = to_exact_double(s.center().y(), r.y) && exact;
+      exact = to_exact_double(s.center().z(), r.z) && exact;
+      exact = ((_header.radius_kind == Sphere_file_header::RADIUS)
+          ? to_exact_radius(s.squared_radius(), r.r)
+          : to_exact_double(s.squared_radius(), r.r)) && exact;
+      if (exact || round)
+      { write(r); }
+      return exact;
+    }
+
+    // Number of spheres written
+    std::size_t size() const
+    { return _header.size; }
+
+    // Finish the file (writing its header), throwing std::runtime_error
+    // when it can't be
+    void close();
+
+  private:
+    template <typename FT>
+    static bool to_exact_double(const FT & x, double & d)
+    { d = CGAL::to_double(x);
+      return FT(d) == x; }
+    // ...same, for the radius given a squared radius (the square
+    // root of the nearest double of the square of a double being
+    // that double)
+    template <typename FT>
+    static bool to_exact_radius(const FT & squared_radius, double & r)
+    { r = std::sqrt(CGAL::to_double(squared_radius));
+      return FT(r) * FT(r) == squared_radius; }
+
+    std::ofstream _stream;
+    Sphere_file_header _header;
+};
+
+// Convert the spheres of a text stream (as written by operator<<) to a
+// sphere file, returning the number of spheres converted: spheres that
+// can't be written exactly (such as decimal coordinates, read as exact
+// fractions) are skipped, or else rounded to the nearest doubles if
+// asked, and counted in a given number
+template <typename SK>
+std::size_t convert_sphere_text(std::istream & is,
+    Sphere_file_writer & writer, std::size_t & inexact, bool round = false)
+{
+  typedef typename SK::Sphere_3 Sphere_3;
+  std::size_t converted = 0;
+  inexact = 0;
+  for (std::istream_iterator<Sphere_3> it(is);
+      it != std::istream_iterator<Sphere_3>(); it++)
+  {
+    if (writer.write(*it, round) == false)
+    { inexact++;
+      if (round == false)
+      { continue; } }
+    converted++;
+  }
+  return converted;
+}
+
+#endif // SPHERE_FILE_H // vim: ft=cpp et sw=2 sts=2
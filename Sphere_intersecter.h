@@ -45,13 +45,17 @@ class Sphere_intersecter
 
     Sphere_intersecter():
       _sphere_tree(), _sphere_storage(),
-      _circle_storage(), _stcl(), _ctsl() {}
+      _circle_storage(), _stcl(), _ctsl(),
+      _containers(), _contents(),
+      _stamps(), _last_stamp(0) {}
 
     // Range constructor
     template <typename InputIterator>
     Sphere_intersecter(InputIterator begin, InputIterator end):
       _sphere_tree(), _sphere_storage(),
-      _circle_storage(), _stcl(), _ctsl()
+      _circle_storage(), _stcl(), _ctsl(),
+      _containers(), _contents(),
+      _stamps(), _last_stamp(0)
       {
         for (; begin != end; begin++)
         { add_sphere(*begin); }
@@ -121,6 +125,19 @@ class Sphere_intersecter
     typedef typename Handle_map<Circle_handle,
             Sphere_handle_pair>::Type Circle_to_spheres_link;
 
+    // Link between a sphere and the spheres containing it entirely
+    // (or conversely, contained in it)
+    typedef typename Handle_map<Sphere_handle,
+            std::vector<Sphere_handle> >::Type Containment_link;
+
+  public:
+    // Stamp of a sphere, changing each time its set of circles changes
+    typedef unsigned long Stamp;
+
+  private:
+    // Current stamp of each sphere
+    typedef typename Handle_map<Sphere_handle, Stamp>::Type Sphere_stamps;
+
   public:
     // Add a new sphere, returning a sphere handle (null if not added)
     Sphere_handle add_sphere(const Sphere_3 &);
@@ -163,6 +180,11 @@ class Sphere_intersecter
     Circle_handle find_circle_in_sphere(const Sphere_3 &,
         const Circle_3 &) const;
 
+    // Circles of a sphere, one for each sphere intersecting it (a point
+    // being a circle of null radius). Spheres of a same pencil intersect
+    // a sphere along the same circle: such coincident circles are kept
+    // apart, being different circles (of different sphere pairs), and
+    // only the first one is found by find_circle_in_sphere.
     template <typename OutputIterator>
     OutputIterator circles_on_sphere(const Sphere_3 & s,
         OutputIterator out_it) const
@@ -185,6 +207,33 @@ class Sphere_intersecter
 
     Sphere_handle_pair originating_spheres(const Circle_handle &) const;
 
+    // Spheres containing a sphere entirely (found along with the
+    // intersections, when a sphere doesn't intersect another one)
+    template <typename OutputIterator>
+    OutputIterator containing_spheres(const Sphere_handle & sh,
+        OutputIterator out_it) const
+    {
+      INFER_AUTO(it, _containers.find(sh));
+      if (it != _containers.end())
+      { std::copy(it->second.begin(), it->second.end(), out_it); }
+      return out_it;
+    }
+    // ...only their number, that is the depth of the whole
+    // sphere when it has no circles
+    std::size_t number_of_containing_spheres(const Sphere_handle &) const;
+
+    // Check if a sphere has circles
+    bool has_circles(const Sphere_handle & sh) const
+    { INFER_AUTO(it, _stcl.find(sh));
+      return it != _stcl.end() && it->second.empty() == false; }
+
+    // Stamp of a sphere, only changed when circles are added/removed on
+    // it (or spheres containing it), and never given twice by the same
+    // intersecter (0 if the sphere isn't in the intersecter). Results
+    // depending only on a sphere's circles and containing spheres can
+    // thus be kept as long as its stamp stays the same.
+    Stamp stamp(const Sphere_handle &) const;
+
     // Removes a sphere
     bool remove_sphere(const Sphere_handle &);
 
@@ -196,6 +245,13 @@ class Sphere_intersecter
 
   private:
     void remove_sphere_links(const Sphere_handle &);
+    // ...containment links of a sphere, given a link and its reverse
+    void remove_containment_links(const Sphere_handle &,
+        Containment_link &, Containment_link &);
+
+    // Give a new stamp to a sphere
+    void restamp(const Sphere_handle & sh)
+    { _stamps[sh] = ++_last_stamp; }
 
     // Sphere bundle
     Sphere_handle_tree _sphere_tree;
@@ -207,6 +263,14 @@ class Sphere_intersecter
     // Spheres <-> Circles
     Spheres_to_circle_link _stcl;
     Circle_to_spheres_link _ctsl;
+
+    // Spheres <-> Containing spheres
+    Containment_link _containers;
+    Containment_link _contents;
+
+    // Spheres' stamps
+    Sphere_stamps _stamps;
+    Stamp _last_stamp;
 };
 
 template <typename SK>
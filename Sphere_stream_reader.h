@@ -0,0 +1,89 @@
+#ifndef SPHERE_STREAM_READER_H
+#define SPHERE_STREAM_READER_H
+
+#include <vector>
+#include <istream>
+#include <cstddef>
+
+#include <boost/thread.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/exception_ptr.hpp>
+
+#include <Sphere_intersecter.h>
+
+// Reader of the spheres of a text stream (as written by operator<<), in
+// chunks of a fixed number of spheres, parsed on a background thread:
+// a chunk is parsed while the previous one is used (e.g. inserted into
+// a sphere intersecter), so that the spheres are never all held at once.
+//
+// At most three chunks are held at any time: the one being parsed, the
+// one parsed and waiting, and the one being used.
+//
+// An exception thrown while parsing (e.g. by a stream throwing on
+// errors, or when out of memory) ends the parsing, as a parse error:
+// the spheres parsed before are handed as usual, and the exception is
+// then thrown by next() (once), and thus by read_into().
+template <typename SK>
+class Sphere_stream_reader: boost::noncopyable
+{
+  public:
+    typedef typename SK::Sphere_3 Sphere_3;
+    typedef std::vector<Sphere_3> Chunk;
+
+    // Start parsing a stream, which must outlive the reader
+    Sphere_stream_reader(std::istream &, std::size_t chunk_size = 4096);
+
+    // Stop parsing
+    ~Sphere_stream_reader();
+
+    // Get the next chunk of spheres (swapped with a given one), waiting
+    // until it is parsed, returning false once the stream is over (or
+    // throwing the exception which stopped the parsing, if any)
+    bool next(Chunk &);
+
+    // Insert the (remaining) spheres into a sphere intersecter, chunk
+    // by chunk, returning the number of spheres added
+    std::size_t read_into(Sphere_intersecter<SK> &);
+
+    // Number of spheres handed so far
+    std::size_t size() const
+    { boost::mutex::scoped_lock lock(_mutex);
+      return _size; }
+
+    // Stream position after the spheres handed so far (e.g. for
+    // reporting progress)
+    std::streamoff position() const
+    { boost::mutex::scoped_lock lock(_mutex);
+      return _position; }
+
+    // Whether the stream ended at a parse error (rather than at its
+    // end), once the last chunk is handed
+    bool failed() const
+    { boost::mutex::scoped_lock lock(_mutex);
+      return _failed; }
+
+  private:
+    // Parsing thread main loop
+    void parse();
+
+    std::istream & _is;
+    std::size_t _chunk_size;
+
+    // Parsed chunk, waiting to be handed
+    Chunk _ready;
+    bool _has_ready;
+    std::streamoff _ready_position;
+
+    // State of the parsing
+    bool _done, _failed, _stopping;
+    boost::exception_ptr _exception;
+    std::size_t _size;
+    std::streamoff _position;
+
+    mutable boost::mutex _mutex;
+    boost::condition_variable _parsed;
+    boost::condition_variable _handed;
+    boost::thread _thread;
+};
+
+#endif // SPHERE_STREAM_READER_H // vim: ft=cpp et sw=2 sts=2
@@ -1,8 +1,14 @@
 #ifndef SPHERICAL_UTILS_H
 #define SPHERICAL_UTILS_H
 
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
 #include <functional>
 
+#include <CGAL/enum.h>
+#include <CGAL/Simple_cartesian.h>
+
 template <typename Squared_radius_holder>
 struct Comp_by_squared_radii:
   public std::unary_function<bool, Squared_radius_holder>
@@ -14,4 +20,161 @@ struct Comp_by_squared_radii:
   }
 };
 
+// Side of a pole of a sphere (along the z axis through its center)
+// with respect to another sphere, computed exactly (without the radius)
+template <typename SK>
+CGAL::Bounded_side side_of_pole(const typename SK::Sphere_3 & s,
+    bool north, const typename SK::Sphere_3 & other)
+{
+  typedef typename SK::FT FT;
+
+  // A point p of s is inside the other sphere iff (p - c).n > k,
+  // c being the center of s and n the vector between both centers
+  typename SK::Vector_3 n = other.center() - s.center();
+  FT nz = north ? n.z() : -n.z();
+  FT k = (s.squared_radius() - other.squared_radius() + n.squared_length()) / 2;
+
+  // ...with (p - c).n = r * nz at the pole, r being the radius of s
+  CGAL::Comparison_result c;
+  if (nz >= 0 && k <= 0)
+  { c = (nz == 0 && k == 0) ? CGAL::EQUAL : CGAL::LARGER; }
+  else if (nz <= 0 && k >= 0)
+  { c = CGAL::SMALLER; }
+  else
+  {
+    FT left = s.squared_radius() * nz * nz, right = k * k;
+    if (nz < 0)
+    { std::swap(left, right); }
+    c = (left < right) ? CGAL::SMALLER
+      : (right < left) ? CGAL::LARGER : CGAL::EQUAL;
+  }
+  return (c == CGAL::LARGER) ? CGAL::ON_BOUNDED_SIDE
+    : (c == CGAL::EQUAL) ? CGAL::ON_BOUNDARY : CGAL::ON_UNBOUNDED_SIDE;
+}
+
+// Approximations (with doubles), for measuring on a sphere
+typedef CGAL::Simple_cartesian<double> Approximate_kernel;
+// ...of angles, in radians
+const double pi = 3.14159265358979323846;
+typedef Approximate_kernel::Vector_3 Approximate_vector_3;
+
+// Approximate position of a point with respect to the center of a sphere
+template <typename SK, typename Point>
+Approximate_vector_3 approximate_position(const typename SK::Sphere_3 & s,
+    const Point & p)
+{
+  return Approximate_vector_3(
+      CGAL::to_double(p.x()) - CGAL::to_double(s.center().x()),
+      CGAL::to_double(p.y()) - CGAL::to_double(s.center().y()),
+      CGAL::to_double(p.z()) - CGAL::to_double(s.center().z()));
+}
+
+// Approximate theta (in [0, 2pi)) of a position around a sphere's center
+inline double approximate_theta(const Approximate_vector_3 & p)
+{
+  double theta = std::atan2(p.y(), p.x());
+  return (theta < 0) ? theta + 2 * pi : theta;
+}
+
+// Circle parametrized by an angle, in a frame (u, v) of its plane,
+// for integrating along its arcs
+struct Approximate_circle
+{
+  Approximate_circle(const Approximate_vector_3 & c, double r,
+      const Approximate_vector_3 & u_, const Approximate_vector_3 & v_):
+    center(c), radius(r), u(u_), v(v_) {}
+
+  Approximate_vector_3 point(double a) const
+  { return center + u * (radius * std::cos(a)) + v * (radius * std::sin(a)); }
+  Approximate_vector_3 tangent(double a) const
+  { return v * (radius * std::cos(a)) - u * (radius * std::sin(a)); }
+
+  // Sign of dtheta/da at a given angle
+  bool is_theta_increasing(double a) const
+  { Approximate_vector_3 p = point(a), dp = tangent(a);
+    return p.x() * dp.y() - p.y() * dp.x() >= 0; }
+
+  // z.dtheta/da at a given angle
+  double z_dtheta(double a) const
+  {
+    Approximate_vector_3 p = point(a), dp = tangent(a);
+    double rho2 = p.x() * p.x() + p.y() * p.y();
+    return (rho2 > 0) ? p.z() * (p.x() * dp.y() - p.y() * dp.x()) / rho2 : 0;
+  }
+
+  // Integral of z.dtheta between two angles (Gauss-Legendre), refined
+  // where the arc gets close to a pole, theta varying fast there
+  double integral(double a, double b) const
+  {
+    static const double nodes[4] = { -0.861136311594052575, -0.339981043584856265,
+      0.339981043584856265, 0.861136311594052575 };
+    static const double weights[4] = { 0.347854845137453857, 0.652145154862546143,
+      0.652145154862546143, 0.347854845137453857 };
+    double result = 0;
+    for (std::size_t i = 0; i < 4; i++)
+    { result += weights[i] * z_dtheta(a + (nodes[i] + 1) * (b - a) / 2); }
+    return result * (b - a) / 2;
+  }
+  // ...given its (unrefined) value, to a tolerance per unit of angle
+  double integral(double a, double b, double whole,
+      double tolerance, unsigned int depth) const
+  {
+    double m = (a + b) / 2, left = integral(a, m), right = integral(m, b);
+    if (depth == 0 || std::fabs(left + right - whole) <= tolerance * (b - a))
+    { return left + right; }
+    return integral(a, m, left, tolerance, depth - 1)
+      + integral(m, b, right, tolerance, depth - 1);
+  }
+
+  Approximate_vector_3 center;
+  double radius;
+  Approximate_vector_3 u, v;
+};
+
+// Integral of z.dtheta along a theta-monotone arc of a circle on a
+// sphere, from a source position to a target one with theta increasing
+// (along the whole circle if asked), z and theta being taken around the
+// sphere's center. The area between the arc and the south pole is then
+// r.(r.dtheta + integral), r being the radius of the sphere.
+template <typename SK>
+double approximate_z_dtheta(const typename SK::Sphere_3 & s,
+    const typename SK::Circle_3 & c, const Approximate_vector_3 & source,
+    const Approximate_vector_3 & target, bool whole)
+{
+  // Frame of the circle's plane, starting at the source
+  Approximate_vector_3 center = approximate_position<SK>(s, c.center());
+  Approximate_vector_3 u = source - center;
+  double radius = std::sqrt(u.squared_length());
+  if (radius == 0)
+  { return 0; }
+  u = u / radius;
+  typename SK::Vector_3 n = c.supporting_plane().orthogonal_vector();
+  Approximate_vector_3 v = CGAL::cross_product(Approximate_vector_3(
+        CGAL::to_double(n.x()), CGAL::to_double(n.y()), CGAL::to_double(n.z())), u);
+  v = v / std::sqrt(v.squared_length());
+  Approximate_circle circle(center, radius, u, v);
+
+  // Angle to the target around the circle: theta being monotone along
+  // the arc, the right way is the one where it increases midway
+  Approximate_vector_3 t = target - center;
+  double angle = whole ? 2 * pi : std::atan2(t * v, t * u);
+  if (angle <= 0)
+  { angle += 2 * pi; }
+  if (circle.is_theta_increasing(angle / 2) == false)
+  { circle.v = -v;
+    if (whole == false)
+    { angle = 2 * pi - angle; } }
+
+  // Integrate on pieces of at most pi/8, to a tolerance relative to the
+  // sphere's radius (|z| being at most the radius), proportional to the
+  // angle covered, and refining each piece at most 6 times (down to pi/512)
+  double tolerance = 1e-9 * std::sqrt(source.squared_length());
+  std::size_t pieces = static_cast<std::size_t>(std::ceil(angle / (pi / 8)));
+  double step = angle / pieces, integral = 0;
+  for (std::size_t i = 0; i < pieces; i++)
+  { double a = i * step, b = (i + 1) * step;
+    integral += circle.integral(a, b, circle.integral(a, b), tolerance, 6); }
+  return integral;
+}
+
 #endif // SPHERICAL_UTILS_H // vim: ft=cpp et sw=2 sts=2
@@ -0,0 +1,112 @@
+#ifndef SWEEP_FRAME_H
+#define SWEEP_FRAME_H
+
+#include <cstddef>
+
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+
+// Frame in which a sphere is swept, rotated from the input frame so that
+// the poles of the sweep (along the z axis through the sphere's center)
+// avoid its circles: circles through a pole (polar/bipolar circles) are
+// not handled by the sweep, and inputs aligned on a grid give many of
+// them in the input frame.
+//
+// The rotation is exact, given by a quaternion with integer coefficients
+// (thus with rational coefficients), and its inverse is its transpose.
+// Frames are drawn at random, as the poles avoid the circles of a sphere
+// for almost any rotation.
+template <typename SK>
+class Sweep_frame
+{
+  // Geometrical objects
+  typedef typename SK::FT FT;
+  typedef typename SK::Root_of_2 Root_of_2;
+  typedef typename SK::Root_for_spheres_2_3 Root_for_spheres_2_3;
+  typedef typename SK::Point_3 Point_3;
+  typedef typename SK::Vector_3 Vector_3;
+  typedef typename SK::Sphere_3 Sphere_3;
+  typedef typename SK::Circle_3 Circle_3;
+  typedef typename SK::Circular_arc_point_3 Circular_arc_point_3;
+
+  public:
+    // Input frame
+    Sweep_frame();
+    // ...rotated by a quaternion (not null)
+    Sweep_frame(int, int, int, int);
+
+    bool is_identity() const
+    { return _identity; }
+
+    // From the input frame to this one
+    Point_3 to_frame(const Point_3 &) const;
+    Vector_3 to_frame(const Vector_3 &) const;
+    Sphere_3 to_frame(const Sphere_3 &) const;
+    Circle_3 to_frame(const Circle_3 &) const;
+
+    // ...and back
+    Point_3 from_frame(const Point_3 &) const;
+    Circular_arc_point_3 from_frame(const Circular_arc_point_3 &) const;
+
+    // Number of circles of a sphere (given by a range of circle
+    // handles) which are degenerate for the sweep in this frame
+    template <typename InputIterator>
+    std::size_t degeneracies(const Sphere_3 & s,
+        InputIterator begin, InputIterator end) const
+    {
+      Sphere_3 fs = to_frame(s);
+      std::size_t n = 0;
+      for (; begin != end; begin++)
+      { CGAL::Circle_type type = CGAL::classify(to_frame(**begin), fs);
+        if (type == CGAL::POLAR || type == CGAL::BIPOLAR)
+        { n++; } }
+      return n;
+    }
+
+    // Choose a frame of a sphere where none of its circles is
+    // degenerate: the input frame if possible, or else a frame rotated
+    // by random (but reproducible) quaternions, drawn until one fits.
+    // Returns false (giving the input frame) if none was found after
+    // a number of draws.
+    template <typename InputIterator>
+    static bool choose(const Sphere_3 & s,
+        InputIterator begin, InputIterator end, Sweep_frame & frame)
+    {
+      frame = Sweep_frame();
+      if (frame.degeneracies(s, begin, end) == 0)
+      { return true; }
+      boost::random::mt19937 rng(Seed);
+      boost::random::uniform_int_distribution<int> coefficient(
+          -Max_coefficient, Max_coefficient);
+      for (std::size_t i = 0; i < Max_draws; i++)
+      {
+        int a = coefficient(rng), b = coefficient(rng),
+            c = coefficient(rng), d = coefficient(rng);
+        if (b == 0 && c == 0 && d == 0)
+        { continue; }
+        frame = Sweep_frame(a, b, c, d);
+        if (frame.degeneracies(s, begin, end) == 0)
+        { return true; }
+      }
+      frame = Sweep_frame();
+      return false;
+    }
+
+  private:
+    // Random quaternions: seed, range of their (integer) coefficients,
+    // kept small for the rotated coordinates to stay small rationals,
+    // and number of draws
+    static const unsigned int Seed = 5489u;
+    static const int Max_coefficient = 16;
+    static const std::size_t Max_draws = 64;
+
+    // Apply the rotation or its inverse (its transpose)
+    template <typename NT>
+    void rotate(const NT &, const NT &, const NT &,
+        NT *, NT *, NT *, bool) const;
+
+    FT _m[3][3];
+    bool _identity;
+};
+
+#endif // SWEEP_FRAME_H // vim: ft=cpp et sw=2 sts=2
@@ -0,0 +1,100 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <deque>
+
+#include <boost/thread.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/exception_ptr.hpp>
+
+// Pool of worker threads, started once and reused for running tasks,
+// so that short tasks don't pay for creating their own threads.
+//
+// Tasks are run through a task group, which allows waiting for them:
+// a waiting thread runs queued tasks itself meanwhile, so that waiting
+// from within a task never deadlocks (and a pool without any thread
+// simply runs the tasks when waiting). A task throwing doesn't stop the
+// pool nor the other tasks: the first exception thrown by the tasks of
+// a group is kept, and thrown again once waiting for the group is done.
+class Thread_pool: boost::noncopyable
+{
+  public:
+    typedef boost::function<void ()> Task;
+
+    class Task_group;
+
+    // Start a given number of threads
+    // (by default, as many as hardware threads)
+    explicit Thread_pool(unsigned int threads
+        = boost::thread::hardware_concurrency());
+
+    // Run the remaining tasks, and stop the threads
+    ~Thread_pool();
+
+    // Number of threads
+    unsigned int size() const
+    { return _size; }
+
+  private:
+    struct Queued_task
+    {
+      Queued_task(const Task & t, Task_group * g):
+        task(t), group(g) {}
+
+      Task task;
+      Task_group * group;
+    };
+    typedef std::deque<Queued_task> Queued_tasks;
+
+    // Queue a task of a group
+    void push(const Task &, Task_group *);
+
+    // Run a queued task, the pool's lock being held (and released
+    // while running the task)
+    void run_front(boost::unique_lock<boost::mutex> &);
+
+    // Thread main loop
+    void work();
+
+    unsigned int _size;
+    bool _stopping;
+    Queued_tasks _tasks;
+    boost::mutex _mutex;
+    boost::condition_variable _task_queued;
+    boost::condition_variable _task_done;
+    boost::thread_group _threads;
+};
+
+// Group of tasks run on a thread pool, waited for all at once
+class Thread_pool::Task_group: boost::noncopyable
+{
+  friend class Thread_pool;
+
+  public:
+    Task_group(Thread_pool & pool):
+      _pool(pool), _pending(0), _exception() {}
+
+    // Wait for the remaining tasks (their exceptions being dropped)
+    ~Task_group()
+    { wait_pending(); }
+
+    // Run a task on the pool
+    void run(const Task & task)
+    { _pool.push(task, this); }
+
+    // Wait until all the tasks of the group are done, throwing
+    // the first exception thrown by them (if any)
+    void wait();
+
+  private:
+    // Wait without throwing
+    void wait_pending();
+
+    Thread_pool & _pool;
+    std::size_t _pending;
+    // ...first exception thrown by the tasks
+    boost::exception_ptr _exception;
+};
+
+#endif // THREAD_POOL_H // vim: ft=cpp et sw=2 sts=2
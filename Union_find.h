@@ -0,0 +1,80 @@
+#ifndef UNION_FIND_H
+#define UNION_FIND_H
+
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+// Disjoint sets of elements numbered from 0, with union by size and
+// path halving: any sequence of operations runs in near-linear time
+class Union_find
+{
+  public:
+    typedef std::size_t Element;
+
+    Union_find():
+      _parents(), _sizes(), _n_sets(0) {}
+
+    // Add an element, in its own set
+    Element add()
+    { _parents.push_back(_parents.size());
+      _sizes.push_back(1);
+      _n_sets++;
+      return _parents.size() - 1; }
+
+    // Representative of the set of an element
+    Element find(Element e)
+    {
+      while (_parents[e] != e)
+      { _parents[e] = _parents[_parents[e]];
+        e = _parents[e]; }
+      return e;
+    }
+
+    // Merge the sets of two elements, returning whether they
+    // were in different sets
+    bool unite(Element e1, Element e2)
+    {
+      e1 = find(e1);
+      e2 = find(e2);
+      if (e1 == e2)
+      { return false; }
+      if (_sizes[e1] < _sizes[e2])
+      { std::swap(e1, e2); }
+      _parents[e2] = e1;
+      _sizes[e1] += _sizes[e2];
+      _n_sets--;
+      return true;
+    }
+
+    // Number the sets from 0, giving the number of each element's
+    // set, in order of their first element
+    std::vector<std::size_t> numbering()
+    {
+      const std::size_t none = std::size_t(-1);
+      std::vector<std::size_t> numbers(_parents.size(), none), result;
+      result.reserve(_parents.size());
+      std::size_t n = 0;
+      for (Element e = 0; e < _parents.size(); e++)
+      { std::size_t & number = numbers[find(e)];
+        if (number == none)
+        { number = n++; }
+        result.push_back(number); }
+      return result;
+    }
+
+    std::size_t size() const
+    { return _parents.size(); }
+    std::size_t number_of_sets() const
+    { return _n_sets; }
+
+    void clear()
+    { _parents.clear(); _sizes.clear(); _n_sets = 0; }
+
+  private:
+    std::vector<Element> _parents;
+    std::vector<std::size_t> _sizes;
+    std::size_t _n_sets;
+};
+
+#endif // UNION_FIND_H // vim: ft=cpp et sw=2 sts=2
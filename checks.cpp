@@ -0,0 +1,539 @@
+// Behavior checks, run by ctest: each check prints the failed
+// conditions, and the executable fails if any of them did
+#include <map>
+#include <vector>
+#include <utility>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+#include <boost/bind.hpp>
+
+#include <Thread_pool.h>
+#include <Sphere_file.h>
+#include <Sphere_stream_reader.h>
+#include <Molecular_reader.h>
+#include <Sphere_intersecter.h>
+#include <Event_queue.h>
+#include <Event_queue_builder.h>
+#include <BO_algorithm_for_spheres.h>
+#include "lib/kernel.h"
+
+typedef SK::Sphere_3 Sphere_3;
+typedef SK::Point_3 Point_3;
+typedef SK::FT FT;
+
+typedef Sphere_intersecter<SK> SI;
+typedef SI::Circle_handle Circle_handle;
+typedef SI::Sphere_handle Sphere_handle;
+typedef SI::Sphere_iterator Sphere_iterator;
+
+typedef Event_queue<SK> EQ;
+typedef EQ::Events Events;
+typedef Events::Normal_event_site Normal_event_site;
+
+// Number of failed checks
+static unsigned int failures = 0;
+
+#define CHECK(condition) check((condition), #condition, __FILE__, __LINE__)
+
+static bool check(bool condition, const char * text,
+    const char * file, int line)
+{
+  if (condition == false)
+  { std::cerr << file << ':' << line << ": check failed: " << text << std::endl;
+    failures++; }
+  return condition;
+}
+
+// Exact sphere, given its squared radius
+static Sphere_3 sphere(const FT & x, const FT & y, const FT & z, const FT & r2)
+{ return Sphere_3(Point_3(x, y, z), r2); }
+
+// Queue builders
+
+// Events of a normal site, in an order not depending on the builder
+typedef std::pair<std::pair<Circle_handle, Circle_handle>, int> Intersection_key;
+struct Site_events
+{
+  Site_events(const Normal_event_site & nes)
+  {
+    for (Normal_event_site::Start_events::const_iterator it = nes.start_events().begin();
+        it != nes.start_events().end(); it++)
+    { starts.push_back(it->circle); }
+    for (Normal_event_site::End_events::const_iterator it = nes.end_events().begin();
+        it != nes.end_events().end(); it++)
+    { ends.push_back(it->circle); }
+    for (Normal_event_site::Intersection_events::const_iterator it = nes.intersection_events().begin();
+        it != nes.intersection_events().end(); it++)
+    { std::pair<Circle_handle, Circle_handle> circles = it->circles;
+      if (circles.second < circles.first)
+      { std::swap(circles.first, circles.second); }
+      intersections.push_back(Intersection_key(circles, it->type)); }
+    std::sort(starts.begin(), starts.end());
+    std::sort(ends.begin(), ends.end());
+    std::sort(intersections.begin(), intersections.end());
+  }
+
+  bool operator==(const Site_events & se) const
+  { return starts == se.starts && ends == se.ends
+      && intersections == se.intersections; }
+
+  std::vector<Circle_handle> starts, ends;
+  std::vector<Intersection_key> intersections;
+};
+
+// Check that two queues hold the same sites, in the same order
+static bool same_queues(EQ & eq1, EQ & eq2)
+{
+  eq1.set_ordering(EQ::Static_schedule);
+  eq2.set_ordering(EQ::Static_schedule);
+  EQ::Cursor c1(eq1), c2(eq2);
+  if (c1.size() != c2.size())
+  { return false; }
+  while (c1.empty() == false)
+  {
+    if (c1.next_event() != c2.next_event())
+    { return false; }
+    switch (c1.next_event())
+    {
+      case EQ::Normal:
+        {
+          const Normal_event_site & nes1 = c1.pop_normal();
+          const Normal_event_site & nes2 = c2.pop_normal();
+          if (nes1.point() != nes2.point()
+              || (Site_events(nes1) == Site_events(nes2)) == false)
+          { return false; }
+        }
+        break;
+      case EQ::Polar:
+        if ((c1.pop_polar().event() == c2.pop_polar().event()) == false)
+        { return false; }
+        break;
+      case EQ::Bipolar:
+        {
+          const Events::Bipolar_event & bpe1 = c1.pop_bipolar().event();
+          const Events::Bipolar_event & bpe2 = c2.pop_bipolar().event();
+          if (bpe1.circle != bpe2.circle || bpe1.tag != bpe2.tag)
+          { return false; }
+        }
+        break;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+// Check that the scene builder gives the queues of the per-sphere builder
+static void check_scene_queues(const std::vector<Sphere_3> & spheres)
+{
+  SI si(spheres.begin(), spheres.end());
+  Scene_event_queue_builder<SK>::Event_queue_map scene =
+    Scene_event_queue_builder<SK>()(si);
+  SI::Sphere_iterator_range range = si.spheres();
+  for (Sphere_iterator it = range.begin(); it != range.end(); it++)
+  {
+    Sphere_handle sh = *it;
+    EQ per_sphere = Event_queue_builder<SK>()(si, sh);
+    CHECK(scene.find(sh) != scene.end()
+        && same_queues(scene[sh], per_sphere));
+  }
+}
+
+static void check_queue_builders()
+{
+  std::vector<Sphere_3> spheres;
+
+  // S and B touching at a point of A (the circles A∩S and A∩B meeting
+  // there), along with a sphere crossing them all
+  spheres.push_back(sphere(0, 0, 0, 1));
+  spheres.push_back(sphere(2, 0, 0, 1));
+  spheres.push_back(sphere(1, 1, 0, 1));
+  spheres.push_back(sphere(1, 0, 1, 1));
+  check_scene_queues(spheres);
+  // ...in any insertion order
+  std::reverse(spheres.begin(), spheres.end());
+  check_scene_queues(spheres);
+
+  // A and B only touching, at a point of S
+  spheres.clear();
+  spheres.push_back(sphere(0, 0, 0, 1));
+  spheres.push_back(sphere(1, FT(1) / 2, 0, FT(1) / 4));
+  spheres.push_back(sphere(1, -FT(1) / 2, 0, FT(1) / 4));
+  check_scene_queues(spheres);
+  std::reverse(spheres.begin(), spheres.end());
+  check_scene_queues(spheres);
+
+  // Coincident circles: spheres of a same pencil, meeting
+  // along the circle x = 1, and crossed by another sphere
+  spheres.clear();
+  spheres.push_back(sphere(0, 0, 0, 2));
+  spheres.push_back(sphere(2, 0, 0, 2));
+  spheres.push_back(sphere(3, 0, 0, 5));
+  spheres.push_back(sphere(1, 1, 0, 1));
+  check_scene_queues(spheres);
+  std::reverse(spheres.begin(), spheres.end());
+  check_scene_queues(spheres);
+
+  // Generic crossings
+  spheres.clear();
+  spheres.push_back(sphere(0, 0, 0, 4));
+  spheres.push_back(sphere(1, 1, 0, 3));
+  spheres.push_back(sphere(-1, 1, 1, 2));
+  spheres.push_back(sphere(0, -1, 1, 3));
+  spheres.push_back(sphere(1, 0, -1, 2));
+  check_scene_queues(spheres);
+}
+
+// Areas of the faces by depth
+
+typedef BO_algorithm_for_spheres<SK> BO;
+
+static bool close_to(double value, double expected)
+{ return std::abs(value - expected) <= 1e-6 * std::abs(expected); }
+
+static void check_depth_areas()
+{
+  // Unit spheres whose centers are 1 apart: each one has a cap of
+  // height 1/2 inside the other (an area of pi), without any sink
+  BO bo;
+  Sphere_handle sh1 = bo.add_sphere(sphere(0, 0, 0, 1));
+  Sphere_handle sh2 = bo.add_sphere(sphere(1, 0, 0, 1));
+  Sphere_handle sh3 = bo.add_sphere(sphere(10, 0, 0, 1));
+  CHECK(bo.run_for_all() == BO::Completed);
+
+  BO::Depth_areas areas;
+  CHECK(bo.depth_areas(sh1, areas) && areas.size() == 2
+      && close_to(areas[0], 3 * pi) && close_to(areas[1], pi));
+  CHECK(bo.depth_areas(sh2, areas) && areas.size() == 2
+      && close_to(areas[0], 3 * pi) && close_to(areas[1], pi));
+  // ...and a lone sphere
+  CHECK(bo.depth_areas(sh3, areas) && areas.size() == 1
+      && close_to(areas[0], 4 * pi));
+
+  // Areas of dirty diagrams aren't given
+  bo.add_sphere(sphere(0, 0, 1, 1));
+  CHECK(bo.depth_areas(sh1, areas) == false);
+}
+
+// Diagram statistics, and faces merged by the sweep
+
+// Sink counting the faces of a sphere, once merged
+struct Face_counter: Arrangement_sink<SK>
+{
+  Face_counter(const Sphere_handle & sh):
+    sphere(sh), faces(0) {}
+
+  void vertex(const Sphere_handle &, Vertex_id,
+      const SK::Circular_arc_point_3 &) {}
+  void edge(const Sphere_handle &, Edge_id, const Circle_handle &,
+      Vertex_id, Vertex_id, Face_id, Face_id) {}
+  void face(const Sphere_handle &, Face_id, int) {}
+  void merged_face(const Sphere_handle & sh, Face_id, Face_id merged)
+  { if (sh == sphere)
+    { faces = std::max(faces, merged + 1); } }
+
+  Sphere_handle sphere;
+  std::size_t faces;
+};
+
+// Statistics of the first sphere of a scene, checking that the sweep
+// gives as many faces
+static Diagram_statistics first_statistics(const std::vector<Sphere_3> & spheres)
+{
+  BO bo;
+  Sphere_handle sh = bo.add_sphere(spheres.front());
+  bo.add_sphere(spheres.begin() + 1, spheres.end());
+  Diagram_statistics stats = bo.statistics_for(sh);
+  Face_counter counter(sh);
+  bo.set_arrangement_sink(&counter);
+  CHECK(bo.run_for(sh) == BO::Completed && counter.faces == stats.faces);
+  return stats;
+}
+
+static void check_statistics()
+{
+  std::vector<Sphere_3> spheres;
+
+  // Two circles crossing at two points, and a circle apart (around
+  // the south pole): V - E + F = 1 + C, with 3 vertices (one of them
+  // closing the lone circle), 5 edges and 2 components
+  spheres.push_back(sphere(0, 0, 0, 4));
+  spheres.push_back(sphere(2, 0, 0, 4));
+  spheres.push_back(sphere(0, 2, 0, 4));
+  spheres.push_back(sphere(0, 0, -2, 1));
+  Diagram_statistics stats = first_statistics(spheres);
+  CHECK(stats.normal_circles == 2 && stats.threaded_circles == 1);
+  CHECK(stats.crossings == 2 && stats.tangencies == 0);
+  CHECK(stats.vertices == 3 && stats.edges == 5);
+  CHECK(stats.components == 2 && stats.faces == 5);
+
+  // Coincident circles, counted apart: an empty face lies between them
+  spheres.clear();
+  spheres.push_back(sphere(0, 0, 0, 2));
+  spheres.push_back(sphere(2, 0, 0, 2));
+  spheres.push_back(sphere(3, 0, 0, 5));
+  stats = first_statistics(spheres);
+  CHECK(stats.normal_circles == 2 && stats.crossings == 0);
+  CHECK(stats.vertices == 2 && stats.edges == 2);
+  CHECK(stats.components == 2 && stats.faces == 3);
+}
+
+// Circles through the poles
+
+static unsigned int degenerate_spheres = 0;
+
+static void count_degenerate(const Sphere_handle &)
+{ degenerate_spheres++; }
+
+static void check_polar_circles()
+{
+  // The circle between both spheres passes through the north pole of
+  // the first one in the input frame
+  BO bo;
+  Sphere_handle sh = bo.add_sphere(sphere(0, 0, 0, 1));
+  bo.add_sphere(sphere(1, 0, 1, 1));
+  BO::Run_options options;
+  options.degenerate = count_degenerate;
+
+  // Without frame choice, the sphere is given up (and reported)
+  bo.set_sweep_frame_choice(false);
+  CHECK(bo.run_for(sh, options) == BO::Degenerate);
+  CHECK(degenerate_spheres == 1 && bo.is_dirty(sh));
+
+  // ...and swept in another frame otherwise
+  bo.set_sweep_frame_choice(true);
+  CHECK(bo.run_for(sh, options) == BO::Completed);
+  CHECK(degenerate_spheres == 1 && bo.is_dirty(sh) == false);
+}
+
+// Sphere files
+
+// Spheres read back from a sphere file
+static std::vector<Sphere_3> read_spheres(const Sphere_file_reader & file)
+{ return std::vector<Sphere_3>(file.spheres_begin<SK>(), file.spheres_end<SK>()); }
+
+static void check_sphere_files()
+{
+  std::vector<Sphere_3> spheres;
+  spheres.push_back(sphere(FT(3) / 2, -2, FT(1) / 4, 9));
+  spheres.push_back(sphere(0, 1e10, -1e-10, FT(9) / 4));
+
+  // Round trip, with squared radii or radii
+  {
+    Sphere_file_writer writer("checks.sph");
+    for (std::size_t i = 0; i < spheres.size(); i++)
+    { CHECK(writer.write(spheres[i])); }
+    writer.close();
+    Sphere_file_reader file("checks.sph");
+    CHECK(file.has_radii() == false && read_spheres(file) == spheres);
+  }
+  {
+    Sphere_file_writer writer("checks.sph", Sphere_file_header::RADIUS);
+    for (std::size_t i = 0; i < spheres.size(); i++)
+    { CHECK(writer.write(spheres[i])); }
+    // ...a squared radius which isn't the square of a double
+    CHECK(writer.write(sphere(0, 0, 0, 2)) == false);
+    writer.close();
+    Sphere_file_reader file("checks.sph");
+    CHECK(file.has_radii() && read_spheres(file) == spheres);
+  }
+
+  // Text conversion: decimal coordinates aren't doubles, and are
+  // skipped unless rounded
+  std::ostringstream text;
+  text << spheres[0] << '\n' << sphere(FT(1) / 10, 0, 0, 1) << '\n';
+  for (int round = 0; round < 2; round++)
+  {
+    std::istringstream is(text.str());
+    std::size_t inexact;
+    {
+      Sphere_file_writer writer("checks.sph");
+      CHECK(convert_sphere_text<SK>(is, writer, inexact, round != 0)
+          == std::size_t(1 + round));
+      CHECK(inexact == 1);
+    }
+    Sphere_file_reader file("checks.sph");
+    CHECK(file.size() == std::size_t(1 + round)
+        && read_spheres(file).front() == spheres[0]);
+  }
+
+  // Invalid records make the whole file rejected
+  const double invalid_radii[] = { 0, -1, std::numeric_limits<double>::quiet_NaN() };
+  for (int i = 0; i < 3; i++)
+  {
+    {
+      Sphere_file_writer writer("checks.sph");
+      Sphere_record valid = { 1, 2, 3, 4 }, invalid = { 1, 2, 3, invalid_radii[i] };
+      writer.write(valid);
+      writer.write(invalid);
+    }
+    bool rejected = false;
+    try
+    { Sphere_file_reader file("checks.sph"); }
+    catch (const std::runtime_error &)
+    { rejected = true; }
+    CHECK(rejected);
+  }
+  std::remove("checks.sph");
+}
+
+// Text streams of spheres
+
+static void check_sphere_streams()
+{
+  std::ostringstream text;
+  for (int i = 0; i < 10; i++)
+  { text << sphere(3 * i, 0, 0, 1) << '\n'; }
+
+  // Read in small chunks, up to the end
+  {
+    std::istringstream is(text.str());
+    SI si;
+    Sphere_stream_reader<SK> reader(is, 3);
+    CHECK(reader.read_into(si) == 10 && reader.failed() == false);
+  }
+
+  // ...or up to a parse error, with a stream throwing on errors: the
+  // spheres before are read, and the exception is thrown afterwards
+  {
+    std::istringstream is(text.str() + "1 2 x\n");
+    is.exceptions(std::ios::failbit | std::ios::badbit);
+    SI si;
+    Sphere_stream_reader<SK> reader(is, 3);
+    bool thrown = false;
+    try
+    { reader.read_into(si); }
+    catch (const std::ios::failure &)
+    { thrown = true; }
+    CHECK(thrown && reader.failed() && reader.size() == 10);
+    SI::Sphere_iterator_range spheres = si.spheres();
+    CHECK(std::distance(spheres.begin(), spheres.end()) == 10);
+  }
+}
+
+// Molecular files
+
+// Write a file, and read its atoms (false if rejected)
+static bool read_atoms(Molecular_reader & reader, const char * filename,
+    const std::string & content, Thread_pool & pool)
+{
+  { std::ofstream ofs(filename, std::ios::binary);
+    ofs << content; }
+  bool read = true;
+  try
+  { reader.read(filename, Molecular_reader::format_of(filename), pool); }
+  catch (const std::runtime_error &)
+  { read = false; }
+  std::remove(filename);
+  return read;
+}
+
+// PDB atom line, with a given name (columns 13-16) and element
+// (columns 77-78, blank if empty)
+static std::string pdb_atom(int serial, const char * name, double x,
+    double y, double z, const char * element = "")
+{
+  char line[128];
+  std::sprintf(line, "ATOM  %5d %-4s ALA A   1    %8.3f%8.3f%8.3f"
+      "  1.00  0.00          %2s\n", serial, name, x, y, z, element);
+  return line;
+}
+
+static bool same_record(const Sphere_record & r, double x, double y,
+    double z, double radius)
+{ return r.x == x && r.y == y && r.z == z && r.r == radius; }
+
+static void check_molecular_files()
+{
+  Thread_pool pool(2);
+  Radius_table radii;
+  radii.set("HG", 2);
+  Molecular_reader reader(radii);
+
+  // XYZR, skipping comments and atoms without a positive radius
+  CHECK(read_atoms(reader, "checks.xyzr",
+        "# x y z r\n1 2 3 1.5\n4 5 6 0\n7 8 9 2\n", pool));
+  CHECK(reader.size() == 2 && reader.skipped() == 1);
+  CHECK(reader.size() == 2 && same_record(reader.records()[0], 1, 2, 3, 1.5)
+      && same_record(reader.records()[1], 7, 8, 9, 2)
+      && reader.atom_ids()[1].index == 2);
+
+  // PQR, the radius being the last field
+  CHECK(read_atoms(reader, "checks.pqr",
+        "MODEL 3\nATOM      7  N   ALA A   1      1.250  -2.000   0.500  0.1414 1.8240\n", pool));
+  CHECK(reader.size() == 1 && same_record(reader.records()[0], 1.25, -2, 0.5, 1.824)
+      && reader.atom_ids()[0].serial == 7 && reader.atom_ids()[0].model == 3);
+
+  // PDB, the elements being given by the element columns, or else by
+  // the alignment of the names
+  std::string pdb = pdb_atom(1, " CA ", 1, 2, 3) + pdb_atom(2, "HG12", 1, 2, 3)
+    + pdb_atom(3, "HG", 1, 2, 3) + pdb_atom(4, "1HG1", 1, 2, 3)
+    + pdb_atom(5, " OXT", 1, 2, 3) + pdb_atom(6, "CA", 1, 2, 3, "ZN");
+  const double pdb_radii[] = { 1.7, 1.2, 2, 1.2, 1.52, 1.39 };
+  CHECK(read_atoms(reader, "checks.pdb", pdb, pool) && reader.size() == 6);
+  for (std::size_t i = 0; i < reader.size() && i < 6; i++)
+  { CHECK(same_record(reader.records()[i], 1, 2, 3, pdb_radii[i])
+      && reader.atom_ids()[i].serial == long(i + 1)); }
+
+  // Non finite values are malformed
+  CHECK(read_atoms(reader, "checks.xyzr", "1 2 3 nan\n", pool) == false);
+  CHECK(read_atoms(reader, "checks.xyzr", "1 inf 3 1\n", pool) == false);
+  CHECK(read_atoms(reader, "checks.pdb",
+        pdb_atom(1, " CA ", 1, std::numeric_limits<double>::quiet_NaN(), 3), pool) == false);
+}
+
+// Thread pool
+
+static void count_task(unsigned int * count, bool fail)
+{
+  (*count)++;
+  if (fail)
+  { throw std::runtime_error("task failed"); }
+}
+
+static void check_thread_pool()
+{
+  // The first exception of a group is thrown once all its tasks are
+  // done, and only once, whether the tasks run on threads or not
+  for (unsigned int threads = 0; threads < 3; threads++)
+  {
+    Thread_pool pool(threads);
+    Thread_pool::Task_group group(pool);
+    unsigned int counts[16] = { 0 };
+    for (unsigned int i = 0; i < 16; i++)
+    { group.run(boost::bind(count_task, &counts[i], i % 4 == 1)); }
+    bool thrown = false;
+    try
+    { group.wait(); }
+    catch (const std::runtime_error &)
+    { thrown = true; }
+    CHECK(thrown);
+    CHECK(std::count(counts, counts + 16, 1u) == 16);
+    group.wait();
+  }
+}
+
+int main()
+{
+  check_queue_builders();
+  check_depth_areas();
+  check_statistics();
+  check_polar_circles();
+  check_sphere_files();
+  check_sphere_streams();
+  check_molecular_files();
+  check_thread_pool();
+
+  if (failures != 0)
+  { std::cerr << failures << " check(s) failed" << std::endl; }
+  return failures == 0 ? 0 : 1;
+}
+
+// vim: ft=cpp et sw=2 sts=2
@@ -0,0 +1,97 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <stdexcept>
+
+#include <Sphere_file.h>
+#include <Molecular_reader.h>
+#include "lib/kernel.h"
+
+// Convert the atoms of a molecular file (XYZR, PQR or PDB, see
+// Molecular_reader.h) to a sphere file holding radii
+static int convert_molecular(const char * input, const char * output,
+    Molecular_reader::Format format)
+{
+  try
+  {
+    Thread_pool pool;
+    Molecular_reader reader;
+    reader.read(input, format, pool);
+    Sphere_file_writer writer(output, Sphere_file_header::RADIUS);
+    for (Molecular_reader::Records::const_iterator it = reader.records().begin();
+        it != reader.records().end(); it++)
+    { writer.write(*it); }
+    writer.close();
+    std::cout << "Converted " << reader.size() << " atoms" << std::endl;
+    if (reader.skipped() > 0)
+    {
+      std::cerr << "Skipped " << reader.skipped() << " atoms"
+        << " (non positive radius)" << std::endl;
+    }
+  }
+  catch (const std::runtime_error & e)
+  {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+// Convert a text sphere file (one sphere per line, as written by
+// operator<<), or a molecular file (by its extension), to a binary
+// sphere file (see Sphere_file.h). Spheres of a text file which aren't
+// made of doubles are skipped, or rounded to the nearest doubles with
+// --round.
+int main(int argc, const char * argv[])
+{
+  bool round = (argc == 4 && std::string(argv[1]) == "--round");
+  if (round)
+  { argv++;
+    argc--; }
+  if (argc != 3)
+  {
+    std::cerr << "Usage: " << argv[0]
+      << " [--round] <text or molecular file> <sphere file>" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Molecular file (known by its extension)
+  Molecular_reader::Format format;
+  bool molecular = true;
+  try
+  { format = Molecular_reader::format_of(argv[1]); }
+  catch (const std::runtime_error &)
+  { molecular = false; }
+  if (molecular)
+  { return convert_molecular(argv[1], argv[2], format); }
+
+  std::ifstream ifs(argv[1]);
+  if (ifs.is_open() == false)
+  {
+    std::cerr << argv[1] << ": cannot open file" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  try
+  {
+    Sphere_file_writer writer(argv[2]);
+    std::size_t inexact;
+    std::size_t converted = convert_sphere_text<SK>(ifs, writer, inexact, round);
+    writer.close();
+    std::cout << "Converted " << converted << " spheres" << std::endl;
+    if (inexact > 0)
+    {
+      std::cerr << (round ? "Rounded " : "Skipped ") << inexact << " spheres"
+        << " (coordinates not representable as doubles)" << std::endl;
+    }
+  }
+  catch (const std::runtime_error & e)
+  {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+// vim: ft=cpp et sw=2 sts=2
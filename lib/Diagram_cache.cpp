@@ -0,0 +1,4 @@
+#include "kernel.h"
+#include <Diagram_cache.ih>
+
+template class Diagram_cache<SK>;
@@ -0,0 +1,4 @@
+#include "kernel.h"
+#include <Diagram_statistics.ih>
+
+template struct Diagram_statistics_builder<SK>;
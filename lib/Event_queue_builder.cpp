@@ -2,3 +2,6 @@
 #include <Event_queue_builder.ih>
 
 template class Event_queue_builder<SK>;
+template class Normal_event_site_map<SK>;
+template class Event_site_collector<SK>;
+template class Scene_event_queue_builder<SK>;
@@ -0,0 +1,4 @@
+#include "kernel.h"
+#include <Event_queue_cache.ih>
+
+template class Event_queue_cache<SK>;
@@ -0,0 +1,339 @@
+#include <Molecular_reader.h>
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+#include <boost/math/special_functions/fpclassify.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace bip = boost::interprocess;
+
+// Minimal size of the pieces parsed in parallel
+static const std::size_t min_piece_size = 1 << 20;
+
+Radius_table::Radius_table():
+  _radii(), _default_radius(1.8)
+{
+  set("H", 1.2);
+  set("C", 1.7);
+  set("N", 1.55);
+  set("O", 1.52);
+  set("F", 1.47);
+  set("P", 1.8);
+  set("S", 1.8);
+  set("CL", 1.75);
+  set("BR", 1.85);
+  set("I", 1.98);
+  set("SE", 1.9);
+  set("NA", 2.27);
+  set("K", 2.75);
+  set("MG", 1.73);
+  set("NI", 1.63);
+  set("CU", 1.4);
+  set("ZN", 1.39);
+}
+
+struct Molecular_reader::Piece
+{
+  Piece():
+    begin(0), end(0), records(), atom_ids(),
+    atoms(0), skipped(0), lines(0), last_model(-1),
+    error_line(0), error() {}
+
+  // Lines of the piece
+  const char * begin, * end;
+
+  // Atoms read (indices and models being local to the piece, models
+  // being -1 before the first MODEL record)
+  Records records;
+  Atom_ids atom_ids;
+  std::size_t atoms, skipped;
+
+  // Number of lines, and model of the last MODEL record (or -1)
+  std::size_t lines;
+  int last_model;
+
+  // First malformed line (local to the piece), and its error
+  std::size_t error_line;
+  std::string error;
+};
+
+// Parse a double, returning whether one was found
+static bool parse_double(const char * s, double & d)
+{
+  char * end;
+  d = std::strtod(s, &end);
+  return end != s;
+}
+
+// Check if the values of a record are all finite
+static bool is_finite(const Sphere_record & r)
+{
+  return (boost::math::isfinite)(r.x) && (boost::math::isfinite)(r.y)
+    && (boost::math::isfinite)(r.z) && (boost::math::isfinite)(r.r);
+}
+
+// Split a line in whitespace separated fields, in place
+static void split_fields(std::string & line, std::vector<const char *> & fields)
+{
+  fields.clear();
+  bool in_field = false;
+  for (std::size_t i = 0; i < line.size(); i++)
+  {
+    if (std::isspace(static_cast<unsigned char>(line[i])))
+    { line[i] = '\0';
+      in_field = false; }
+    else if (in_field == false)
+    { fields.push_back(line.c_str() + i);
+      in_field = true; }
+  }
+}
+
+// Columns of a fixed-column line (empty past its end)
+static std::string columns(const std::string & line,
+    std::size_t first, std::size_t last)
+{
+  if (first >= line.size())
+  { return std::string(); }
+  return line.substr(first, std::min(last, line.size()) - first);
+}
+
+// Element of a PDB atom, from its element columns, or else from the
+// alignment of its name (columns 13-16), where the element is
+// right-justified in columns 13-14: a name starting with a blank or a
+// digit in column 13 has a one-letter element in column 14 (" CA ",
+// "1HG1"), and only two-letter elements start in column 13 ("FE  ",
+// "HG  "), except hydrogens with four-character names ("HG12", "HD21")
+static std::string pdb_element(const std::string & line)
+{
+  std::string element;
+  std::string columns_element = columns(line, 76, 78);
+  for (std::size_t i = 0; i < columns_element.size(); i++)
+  { if (std::isalpha(static_cast<unsigned char>(columns_element[i])))
+    { element += std::toupper(static_cast<unsigned char>(columns_element[i])); } }
+  if (element.empty() == false)
+  { return element; }
+
+  std::string name = columns(line, 12, 16);
+  name.resize(4, ' ');
+  unsigned char first = name[0], second = name[1];
+  if (std::isalpha(first) == false)
+  {
+    if (std::isalpha(second))
+    { element += std::toupper(second); }
+    return element;
+  }
+  element += std::toupper(first);
+  if (std::isalpha(second) && (element != "H" || name[3] == ' '))
+  { element += std::toupper(second); }
+  return element;
+}
+
+Molecular_reader::Format Molecular_reader::format_of(const std::string & filename)
+{
+  std::string extension;
+  std::string::size_type dot = filename.rfind('.');
+  if (dot != std::string::npos)
+  { extension = filename.substr(dot + 1); }
+  std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+  if (extension == "xyzr")
+  { return XYZR; }
+  if (extension == "pqr")
+  { return PQR; }
+  if (extension == "pdb" || extension == "ent")
+  { return PDB; }
+  throw std::runtime_error(filename + ": unknown molecular file format");
+}
+
+void Molecular_reader::parse(Piece & piece, Format format) const
+{
+  std::string line;
+  std::vector<const char *> fields;
+  int model = -1;
+  for (const char * p = piece.begin; p < piece.end; piece.lines++)
+  {
+    const char * nl = static_cast<const char *>(std::memchr(p, '\n', piece.end - p));
+    const char * line_end = (nl == 0) ? piece.end : nl;
+    line.assign(p, line_end);
+    p = line_end + 1;
+    if (line.empty() == false && line[line.size() - 1] == '\r')
+    { line.erase(line.size() - 1); }
+
+    // Get the atom of the line (if any)
+    Sphere_record r;
+    Atom_id id;
+    id.serial = -1;
+    id.model = model;
+    bool atom = false, valid = true;
+    std::string record = columns(line, 0, 6);
+    switch (format)
+    {
+      case XYZR:
+        split_fields(line, fields);
+        if (fields.empty() || fields[0][0] == '#')
+        { break; }
+        atom = true;
+        valid = fields.size() >= 4
+          && parse_double(fields[0], r.x) && parse_double(fields[1], r.y)
+          && parse_double(fields[2], r.z) && parse_double(fields[3], r.r);
+        id.model = 0;
+        break;
+
+      case PQR:
+        split_fields(line, fields);
+        if (fields.empty())
+        { break; }
+        if (std::strcmp(fields[0], "MODEL") == 0 && fields.size() >= 2)
+        { model = piece.last_model = std::atoi(fields[1]); }
+        if (std::strcmp(fields[0], "ATOM") != 0
+            && std::strcmp(fields[0], "HETATM") != 0)
+        { break; }
+        atom = true;
+        {
+          // Last fields: x y z charge radius
+          std::size_t n = fields.size();
+          valid = n >= 7
+            && parse_double(fields[n - 5], r.x) && parse_double(fields[n - 4], r.y)
+            && parse_double(fields[n - 3], r.z) && parse_double(fields[n - 1], r.r);
+          id.serial = std::strtol(fields[1], 0, 10);
+        }
+        break;
+
+      case PDB:
+        if (record == "MODEL ")
+        { model = piece.last_model = std::atoi(columns(line, 6, 14).c_str()); }
+        if (record != "ATOM  " && record != "HETATM")
+        { break; }
+        atom = true;
+        valid = line.size() >= 54
+          && parse_double(columns(line, 30, 38).c_str(), r.x)
+          && parse_double(columns(line, 38, 46).c_str(), r.y)
+          && parse_double(columns(line, 46, 54).c_str(), r.z);
+        r.r = _radii.radius(pdb_element(line));
+        id.serial = std::strtol(columns(line, 6, 11).c_str(), 0, 10);
+        break;
+    }
+    if (atom == false)
+    { continue; }
+
+    // Stop at the first malformed atom (including non finite values)
+    if (valid == false || is_finite(r) == false)
+    {
+      piece.error_line = piece.lines;
+      piece.error = "malformed atom";
+      return;
+    }
+    id.index = piece.atoms++;
+    if (r.r <= 0)
+    { piece.skipped++;
+      continue; }
+    piece.records.push_back(r);
+    piece.atom_ids.push_back(id);
+  }
+}
+
+std::size_t Molecular_reader::read(const std::string & filename,
+    Format format, Thread_pool & pool)
+{
+  _records.clear();
+  _atom_ids.clear();
+  _skipped = 0;
+
+  // Map the file (which can't be done for an empty one)
+  {
+    std::ifstream ifs(filename.c_str(), std::ios::binary | std::ios::ate);
+    if (ifs.is_open() == false)
+    { throw std::runtime_error(filename + ": cannot open file"); }
+    if (ifs.tellg() == std::streamoff(0))
+    { return 0; }
+  }
+  bip::mapped_region region;
+  try
+  {
+    bip::file_mapping file(filename.c_str(), bip::read_only);
+    bip::mapped_region file_region(file, bip::read_only);
+    region.swap(file_region);
+  }
+  catch (const bip::interprocess_exception & e)
+  { throw std::runtime_error(filename + ": " + e.what()); }
+  region.advise(bip::mapped_region::advice_sequential);
+  const char * data = static_cast<const char *>(region.get_address());
+  std::size_t size = region.get_size();
+
+  // Split the file on line boundaries (the pieces may be empty)
+  std::size_t n = std::max(std::min<std::size_t>(4 * pool.size(),
+        size / min_piece_size), std::size_t(1));
+  std::vector<Piece> pieces(n);
+  for (std::size_t i = 0; i < n; i++)
+  {
+    const char * begin = data + size * i / n;
+    if (i > 0)
+    {
+      const char * nl = static_cast<const char *>(
+          std::memchr(begin - 1, '\n', data + size - (begin - 1)));
+      begin = (nl == 0) ? data + size : nl + 1;
+      begin = std::max(begin, pieces[i - 1].begin);
+      pieces[i - 1].end = begin;
+    }
+    pieces[i].begin = begin;
+  }
+  pieces[n - 1].end = data + size;
+
+  // Parse the pieces
+  {
+    Thread_pool::Task_group parsers(pool);
+    for (std::size_t i = 0; i < n; i++)
+    { parsers.run(boost::bind(&Molecular_reader::parse, this,
+          boost::ref(pieces[i]), format)); }
+  }
+
+  // Gather the atoms, giving them their index and model in the file
+  std::size_t total = 0, lines = 0, atoms = 0;
+  for (std::size_t i = 0; i < n; i++)
+  {
+    if (pieces[i].error.empty() == false)
+    {
+      std::ostringstream oss;
+      oss << filename << ":" << lines + pieces[i].error_line + 1
+        << ": " << pieces[i].error;
+      throw std::runtime_error(oss.str());
+    }
+    lines += pieces[i].lines;
+    total += pieces[i].records.size();
+  }
+  _records.reserve(total);
+  _atom_ids.reserve(total);
+  int model = 0;
+  for (std::size_t i = 0; i < n; i++)
+  {
+    Piece & piece = pieces[i];
+    _records.insert(_records.end(), piece.records.begin(), piece.records.end());
+    for (Atom_ids::iterator it = piece.atom_ids.begin();
+        it != piece.atom_ids.end(); it++)
+    {
+      it->index += atoms;
+      if (it->model == -1)
+      { it->model = model; }
+      _atom_ids.push_back(*it);
+    }
+    if (piece.last_model != -1)
+    { model = piece.last_model; }
+    atoms += piece.atoms;
+    _skipped += piece.skipped;
+
+    // Release the piece's atoms as soon as they are gathered
+    Records().swap(piece.records);
+    Atom_ids().swap(piece.atom_ids);
+  }
+  return _records.size();
+}
+
+// vim: ft=cpp et sw=2 sts=2
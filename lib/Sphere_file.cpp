@@ -0,0 +1,109 @@
+#include <Sphere_file.h>
+
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include <boost/math/special_functions/fpclassify.hpp>
+
+static const char sphere_file_magic[8] = {'T', 'D', 'S', 'P', 'H', 'E', 'R', 'E'};
+static const boost::uint32_t sphere_file_version = 1;
+static const boost::uint32_t sphere_file_byte_order = 0x01020304;
+
+namespace bip = boost::interprocess;
+
+bool is_valid_record(const Sphere_record & r)
+{
+  return (boost::math::isfinite)(r.x) && (boost::math::isfinite)(r.y)
+    && (boost::math::isfinite)(r.z) && (boost::math::isfinite)(r.r)
+    && r.r > 0;
+}
+
+Sphere_file_reader::Sphere_file_reader(const std::string & filename):
+  _file(), _region(), _header(0), _records(0)
+{
+  try
+  {
+    bip::file_mapping file(filename.c_str(), bip::read_only);
+    bip::mapped_region region(file, bip::read_only);
+    _file.swap(file);
+    _region.swap(region);
+  }
+  catch (const bip::interprocess_exception & e)
+  { throw std::runtime_error(filename + ": " + e.what()); }
+
+  // Check the header
+  if (_region.get_size() < sizeof(Sphere_file_header))
+  { throw std::runtime_error(filename + ": not a sphere file"); }
+  _header = static_cast<const Sphere_file_header *>(_region.get_address());
+  if (std::memcmp(_header->magic, sphere_file_magic,
+        sizeof(sphere_file_magic)) != 0)
+  { throw std::runtime_error(filename + ": not a sphere file"); }
+  if (_header->version != sphere_file_version)
+  { throw std::runtime_error(filename + ": unknown sphere file version"); }
+  if (_header->byte_order != sphere_file_byte_order)
+  { throw std::runtime_error(filename + ": sphere file of another byte order"); }
+  if (_header->record_size != sizeof(Sphere_record)
+      || (_header->radius_kind != Sphere_file_header::SQUARED_RADIUS
+        && _header->radius_kind != Sphere_file_header::RADIUS))
+  { throw std::runtime_error(filename + ": unknown sphere records"); }
+  std::size_t records_size = _region.get_size() - sizeof(Sphere_file_header);
+  if (_header->size > records_size / sizeof(Sphere_record))
+  { throw std::runtime_error(filename + ": truncated sphere file"); }
+
+  // Records are read in order, checked once here
+  _records = reinterpret_cast<Record_iterator>(_header + 1);
+  _region.advise(bip::mapped_region::advice_sequential);
+  for (std::size_t i = 0; i < size(); i++)
+  {
+    if (is_valid_record(_records[i]) == false)
+    { std::ostringstream oss;
+      oss << filename << ": invalid sphere record " << i
+        << " (not finite, or without a positive radius)";
+      throw std::runtime_error(oss.str()); }
+  }
+}
+
+Sphere_file_writer::Sphere_file_writer(const std::string & filename,
+    Sphere_file_header::Radius_kind radius_kind):
+  _stream(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc),
+  _header()
+{
+  if (_stream.is_open() == false)
+  { throw std::runtime_error(filename + ": cannot create sphere file"); }
+  std::memcpy(_header.magic, sphere_file_magic, sizeof(sphere_file_magic));
+  _header.version = sphere_file_version;
+  _header.byte_order = sphere_file_byte_order;
+  _header.radius_kind = radius_kind;
+  _header.record_size = sizeof(Sphere_record);
+  _header.size = 0;
+
+  // Header, written again on closing (with the number of records)
+  _stream.write(reinterpret_cast<const char *>(&_header), sizeof(_header));
+}
+
+Sphere_file_writer::~Sphere_file_writer()
+{
+  if (_stream.is_open())
+  {
+    try { close(); }
+    catch (const std::runtime_error &) {}
+  }
+}
+
+void Sphere_file_writer::write(const Sphere_record & r)
+{
+  _stream.write(reinterpret_cast<const char *>(&r), sizeof(r));
+  _header.size++;
+}
+
+void Sphere_file_writer::close()
+{
+  _stream.seekp(0);
+  _stream.write(reinterpret_cast<const char *>(&_header), sizeof(_header));
+  _stream.close();
+  if (_stream.fail())
+  { throw std::runtime_error("cannot write sphere file"); }
+}
+
+// vim: ft=cpp et sw=2 sts=2
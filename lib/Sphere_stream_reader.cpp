@@ -0,0 +1,4 @@
+#include "kernel.h"
+#include <Sphere_stream_reader.ih>
+
+template class Sphere_stream_reader<SK>;
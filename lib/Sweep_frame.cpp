@@ -0,0 +1,4 @@
+#include "kernel.h"
+#include <Sweep_frame.ih>
+
+template class Sweep_frame<SK>;
@@ -0,0 +1,96 @@
+#include <Thread_pool.h>
+
+#include <boost/bind.hpp>
+
+Thread_pool::Thread_pool(unsigned int threads):
+  _size(threads), _stopping(false), _tasks(), _mutex(),
+  _task_queued(), _task_done(), _threads()
+{
+  for (unsigned int i = 0; i < threads; i++)
+  { _threads.create_thread(boost::bind(&Thread_pool::work, this)); }
+}
+
+Thread_pool::~Thread_pool()
+{
+  {
+    boost::unique_lock<boost::mutex> lock(_mutex);
+    _stopping = true;
+  }
+  _task_queued.notify_all();
+  _threads.join_all();
+
+  // Without any thread, tasks may be left
+  boost::unique_lock<boost::mutex> lock(_mutex);
+  while (_tasks.empty() == false)
+  { run_front(lock); }
+}
+
+void Thread_pool::push(const Task & task, Task_group * group)
+{
+  {
+    boost::unique_lock<boost::mutex> lock(_mutex);
+    _tasks.push_back(Queued_task(task, group));
+    group->_pending++;
+  }
+  _task_queued.notify_one();
+}
+
+void Thread_pool::run_front(boost::unique_lock<boost::mutex> & lock)
+{
+  Queued_task qt = _tasks.front();
+  _tasks.pop_front();
+  lock.unlock();
+  boost::exception_ptr exception;
+  try
+  { qt.task(); }
+  catch (...)
+  { exception = boost::current_exception(); }
+  lock.lock();
+  if (exception && bool(qt.group->_exception) == false)
+  { qt.group->_exception = exception; }
+  if (--qt.group->_pending == 0)
+  { _task_done.notify_all(); }
+}
+
+void Thread_pool::work()
+{
+  boost::unique_lock<boost::mutex> lock(_mutex);
+  for (;;)
+  {
+    while (_tasks.empty() && _stopping == false)
+    { _task_queued.wait(lock); }
+    if (_tasks.empty())
+    { return; }
+    run_front(lock);
+  }
+}
+
+void Thread_pool::Task_group::wait()
+{
+  wait_pending();
+
+  // Throw the first exception of the tasks (only once)
+  boost::exception_ptr exception;
+  {
+    boost::unique_lock<boost::mutex> lock(_pool._mutex);
+    exception = _exception;
+    _exception = boost::exception_ptr();
+  }
+  if (exception)
+  { boost::rethrow_exception(exception); }
+}
+
+void Thread_pool::Task_group::wait_pending()
+{
+  boost::unique_lock<boost::mutex> lock(_pool._mutex);
+  while (_pending > 0)
+  {
+    // Help running queued tasks (of any group), rather than idling
+    if (_pool._tasks.empty() == false)
+    { _pool.run_front(lock); }
+    else
+    { _pool._task_done.wait(lock); }
+  }
+}
+
+// vim: ft=cpp et sw=2 sts=2
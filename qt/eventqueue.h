@@ -7,6 +7,7 @@
 typedef Event_queue<Kernel> EventQueue;
 typedef EventQueue::Event_site_type EventSiteType;
 typedef EventQueue::Events Events;
+typedef EventQueue::Cursor EventQueueCursor;
 
 typedef Events::Critical_event CriticalEvent;
 typedef Events::Intersection_event IntersectionEvent;
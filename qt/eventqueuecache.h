@@ -0,0 +1,10 @@
+#ifndef EVENTQUEUECACHE_H
+#define EVENTQUEUECACHE_H
+
+#include "kernel.h"
+#include <Event_queue_cache.h>
+
+typedef Event_queue_cache<Kernel> EventQueueCache;
+typedef EventQueueCache::Event_queue_ptr EventQueuePtr;
+
+#endif // EVENTQUEUECACHE_H
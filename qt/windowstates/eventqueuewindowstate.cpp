@@ -8,7 +8,6 @@
 #include <QPushButton>
 #include <QButtonGroup>
 #include <QGLViewer/qglviewer.h>
-#include "../eventqueuebuilder.h"
 #include "../dialogs/selectspheredialog.h"
 #include "../treewidgetitems/spheretreewidgetitem.h"
 #include "../treewidgetitems/nestreewidgetitem.h"
@@ -120,29 +119,31 @@ void EventQueueWindowState::buildEventQueue()
                                                                treeWidget);
         treeWidget->addTopLevelItem(sphereItem);
 
-        // Build event queue
-        eventQueue = EventQueueBuilder()(siProxy.directAccess(),
+        // Build event queue (or reuse the last one built), and
+        // walk it in place, as it's already sorted
+        EventQueuePtr eventQueue = eventQueueCache(siProxy.directAccess(),
                 selectedSphere.handle);
+        EventQueueCursor cursor(*eventQueue);
 
         // Add its new children
-        for (EventSiteType evsType = eventQueue.next_event();
-             evsType != EventQueue::None; evsType = eventQueue.next_event())
+        for (EventSiteType evsType = cursor.next_event();
+             evsType != EventQueue::None; evsType = cursor.next_event())
         {
             QTreeWidgetItem *eventItem = 0;
             if (evsType == EventQueue::Normal)
             {
-                NormalEventSite event = eventQueue.pop_normal();
+                const NormalEventSite &event = cursor.pop_normal();
                 eventItem = new NESTreeWidgetItem(event);
             }
             else if (evsType == EventQueue::Bipolar)
             {
-                BipolarEventSite event = eventQueue.pop_bipolar();
+                const BipolarEventSite &event = cursor.pop_bipolar();
                 eventItem = new BPESTreeWidgetItem(event);
             }
             else
             {
                 Q_ASSERT(evsType == EventQueue::Polar);
-                PolarEventSite event = eventQueue.pop_polar();
+                const PolarEventSite &event = cursor.pop_polar();
                 eventItem = new PESTreeWidgetItem(event);
             }
             sphereItem->addChild(eventItem);
@@ -4,6 +4,7 @@
 #include <QSet>
 #include "windowstatewithmenu.h"
 #include "../eventqueue.h"
+#include "../eventqueuecache.h"
 
 class QTreeWidget;
 class QTreeWidgetItem;
@@ -33,8 +34,9 @@ private:
     // Helper for updating the UI
     void updateUI();
 
-    // Event queue
-    EventQueue eventQueue;
+    // Event queues of previous builds (sorted once), rebuilt
+    // only when the corresponding sphere's circles change
+    EventQueueCache eventQueueCache;
 
     // Tree items to display
     QSet<DrawableTreeWidgetItem*> drawableItems;
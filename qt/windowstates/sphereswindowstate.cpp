@@ -1,18 +1,23 @@
 #include "sphereswindowstate.h"
 #include <fstream>
 #include <limits>
+#include <stdexcept>
 #include <QMenu>
 #include <QMenuBar>
 #include <QSplitter>
 #include <QMainWindow>
 #include <QMessageBox>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QHBoxLayout>
 #include <QVBoxLayout>
 #include <QPushButton>
 #include <QProgressDialog>
 #include <QGLViewer/qglviewer.h>
 #include <CGAL/Random.h>
+#include <Sphere_file.h>
+#include <Sphere_stream_reader.h>
+#include <Molecular_reader.h>
 #include "../dialogs/sphereformdialog.h"
 #include "../dialogs/generatespheresdialog.h"
 #include "../dialogs/selectspheredialog.h"
@@ -171,13 +176,16 @@ void SpheresWindowState::toggleAllCheckState()
     updateDisplay();
 }
 
+bool SpheresWindowState::isSphereFile(const QString &fileName) const
+{ return fileName.endsWith(".sph", Qt::CaseInsensitive); }
+
 void SpheresWindowState::loadPrompt()
 {
     // Get file to load spheres from
     QString fileName = QFileDialog::getOpenFileName(&wsw,
-            tr("Open spheres"), "", tr("Text files (*.txt)"));
-    //if (QFile::exists(fileName) == false) { return; }
-    std::ifstream ifs(fileName.toStdString().c_str());
+            tr("Open spheres"), "", tr("Sphere files (*.sph);;Text files (*.txt);;"
+                                       "Molecular files (*.xyzr *.pqr *.pdb *.ent)"));
+    if (fileName.isEmpty()) { return; }
 
     // Progress bar display
     QProgressDialog pd(&wsw);
@@ -190,36 +198,104 @@ void SpheresWindowState::loadPrompt()
     // Disable menu and window update
     wsw.setUpdatesEnabled(false);
 
-    // Parse file
-    std::vector<Sphere_3> spheres;
-    std::size_t nblines = std::count(std::istreambuf_iterator<char>(ifs),
-                         std::istreambuf_iterator<char>(), '\n');
-    if (nblines > static_cast<std::size_t>(std::numeric_limits<int>::max()))
+    // Load spheres
+    std::size_t nb;
+    try
     {
-        std::ostringstream oss;
-        oss <<  "Cannot load spheres from " << fileName.toStdString()
-             << ": file too large";
-        QMessageBox::warning(&wsw, tr("Error loading"), tr(oss.str().c_str()));
+        QString suffix = QFileInfo(fileName).suffix().toLower();
+        if (isSphereFile(fileName))
+        { nb = loadSphereFile(fileName, pd); }
+        else if (suffix == "xyzr" || suffix == "pqr"
+                 || suffix == "pdb" || suffix == "ent")
+        { nb = loadMolecularFile(fileName, pd); }
+        else
+        { nb = loadTextFile(fileName, pd); }
+    }
+    catch (const std::runtime_error &e)
+    {
+        wsw.setUpdatesEnabled(true);
+        QMessageBox::warning(&wsw, tr("Error loading"), tr(e.what()));
         return;
     }
-    ifs.seekg(0);
-    pd.setMaximum(nblines);
-    pd.setLabelText("Parsing spheres from file '" + fileName + "'");
-    pd.show();
-    spheres.resize(nblines);
-    for (std::istream_iterator<Sphere_3> ifs_it(ifs);
-         ifs_it != std::istream_iterator<Sphere_3>(); ifs_it++)
+
+    // Disable menu and window update
+    wsw.setUpdatesEnabled(true);
+
+    // Update the UI
+    updateDisplay();
+
+    // Show status message
+    std::ostringstream oss;
+    oss << "Loaded " << nb << " spheres";
+    setStatus(QString(oss.str().c_str()));
+}
+
+std::size_t SpheresWindowState::loadTextFile(const QString &fileName,
+                                             QProgressDialog &pd)
+{
+    std::ifstream ifs(fileName.toStdString().c_str());
+    if (ifs.is_open() == false)
     {
-        spheres.push_back(*ifs_it);
-        pd.setValue(pd.value() + 1);
+        throw std::runtime_error("Cannot load spheres from "
+                                 + fileName.toStdString() + ": cannot open file");
     }
 
-    // Copy parsed spheres
+    // Progress (in percents of the file)
+    qint64 fileSize = QFileInfo(fileName).size();
+    pd.setMaximum(100);
+    pd.setLabelText("Loading spheres from file '" + fileName
+                    + "' and computing intersections");
+    pd.show();
+
+    // Parse file in chunks (in the background), adding the spheres of
+    // each chunk meanwhile
+    Sphere_stream_reader<Kernel> reader(ifs);
+    Sphere_stream_reader<Kernel>::Chunk chunk;
     std::size_t nb = 0;
-    pd.setValue(0);
-    pd.setLabelText("Copying spheres and computing intersections");
-    for (std::vector<Sphere_3>::const_iterator it = spheres.begin();
-         it != spheres.end(); it++)
+    while (reader.next(chunk))
+    {
+        for (Sphere_stream_reader<Kernel>::Chunk::const_iterator it = chunk.begin();
+             it != chunk.end(); it++)
+        {
+            SphereHandle sh = siProxy.addSphere(*it);
+            if (sh.is_null() == false)
+            {
+                addNew(sh);
+                nb++;
+            }
+        }
+        if (fileSize > 0)
+        { pd.setValue(static_cast<int>(100 * reader.position() / fileSize)); }
+    }
+    if (reader.failed())
+    {
+        std::ostringstream oss;
+        oss << "Parse error in " << fileName.toStdString()
+            << " after " << reader.size() << " spheres";
+        QMessageBox::warning(&wsw, tr("Error loading"), tr(oss.str().c_str()));
+    }
+    return nb;
+}
+
+std::size_t SpheresWindowState::loadSphereFile(const QString &fileName,
+                                               QProgressDialog &pd)
+{
+    // Map file (spheres being read in place, without parsing)
+    Sphere_file_reader file(fileName.toStdString());
+    if (file.size() > static_cast<std::size_t>(std::numeric_limits<int>::max()))
+    {
+        throw std::runtime_error("Cannot load spheres from "
+                                 + fileName.toStdString() + ": file too large");
+    }
+    pd.setMaximum(file.size());
+    pd.setLabelText("Loading spheres and computing intersections");
+    pd.show();
+
+    // Add spheres
+    typedef Sphere_file_reader::Sphere_iterator<Kernel>::type FileSphereIterator;
+    std::size_t nb = 0, read = 0;
+    for (FileSphereIterator it = file.spheres_begin<Kernel>();
+         it != file.spheres_end<Kernel>(); it++)
     {
         SphereHandle sh = siProxy.addSphere(*it);
         if (sh.is_null() == false)
@@ -227,24 +303,95 @@ void SpheresWindowState::loadPrompt()
             addNew(sh);
             nb++;
         }
+        if (++read % 1024 == 0)
+        { pd.setValue(read); }
     }
+    return nb;
+}
 
-    // Disable menu and window update
-    wsw.setUpdatesEnabled(true);
-
-    // Update the UI
-    updateDisplay();
+std::size_t SpheresWindowState::loadMolecularFile(const QString &fileName,
+                                                  QProgressDialog &pd)
+{
+    // Read atoms (in parallel)
+    pd.setLabelText("Reading atoms from file '" + fileName + "'");
+    pd.setMaximum(0);
+    pd.show();
+    Thread_pool pool;
+    Molecular_reader reader;
+    reader.read(fileName.toStdString(),
+                Molecular_reader::format_of(fileName.toStdString()), pool);
+    if (reader.size() > static_cast<std::size_t>(std::numeric_limits<int>::max()))
+    {
+        throw std::runtime_error("Cannot load spheres from "
+                                 + fileName.toStdString() + ": file too large");
+    }
 
-    // Show status message
-    std::ostringstream oss;
-    oss << "Loaded " << nb << " spheres";
-    setStatus(QString(oss.str().c_str()));
+    // Add spheres
+    pd.setMaximum(reader.size());
+    pd.setLabelText("Adding atoms and computing intersections");
+    typedef Molecular_reader::Sphere_iterator<Kernel>::type AtomSphereIterator;
+    std::size_t nb = 0, read = 0;
+    for (AtomSphereIterator it = reader.spheres_begin<Kernel>();
+         it != reader.spheres_end<Kernel>(); it++)
+    {
+        SphereHandle sh = siProxy.addSphere(*it);
+        if (sh.is_null() == false)
+        {
+            addNew(sh);
+            nb++;
+        }
+        if (++read % 1024 == 0)
+        { pd.setValue(read); }
+    }
+    return nb;
 }
 
 void SpheresWindowState::savePrompt()
 {
     if (openFilename.size() == 0)
     { saveAsPrompt(); }
+    else if (isSphereFile(openFilename))
+    {
+        // Write all (in binary)
+        std::size_t skipped = 0;
+        try
+        {
+            // Radii are written when all the spheres have radii
+            // made of doubles (e.g. atoms), squared radii otherwise
+            SI::Sphere_iterator_range sphere_range(siProxy.directAccess());
+            Sphere_file_header::Radius_kind radiusKind = Sphere_file_header::RADIUS;
+            for (SI::Sphere_iterator it = sphere_range.begin();
+                 it != sphere_range.end(); it++)
+            {
+                if (Sphere_file_writer::has_exact_radius(**it) == false)
+                { radiusKind = Sphere_file_header::SQUARED_RADIUS;
+                  break; }
+            }
+            Sphere_file_writer writer(openFilename.toStdString(), radiusKind);
+            for (SI::Sphere_iterator it = sphere_range.begin();
+                 it != sphere_range.end(); it++)
+            {
+                if (writer.write(**it) == false)
+                { skipped++; }
+            }
+            writer.close();
+        }
+        catch (const std::runtime_error &e)
+        {
+            QMessageBox::warning(&wsw, tr("Error saving"), tr(e.what()));
+            return;
+        }
+
+        // Show status message
+        if (skipped > 0)
+        {
+            std::ostringstream oss;
+            oss << skipped << " spheres not saved to " << openFilename.toStdString()
+                << ": coordinates not representable as doubles";
+            QMessageBox::warning(&wsw, tr("Spheres not saved"), tr(oss.str().c_str()));
+        }
+        setStatus(tr("Saved spheres to ") + openFilename);
+    }
     else
     {
         // Open file
@@ -264,7 +411,8 @@ void SpheresWindowState::savePrompt()
 void SpheresWindowState::saveAsPrompt()
 {
     QString fileName = QFileDialog::getSaveFileName(&wsw,
-            tr("Save spheres"), "", tr("Text files (*.txt)"));
+            tr("Save spheres"), "", tr("Sphere files (*.sph);;Text files (*.txt)"));
+    if (fileName.isEmpty()) { return; }
     openFilename = fileName;
     savePrompt();
 }
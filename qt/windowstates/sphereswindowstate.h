@@ -3,6 +3,7 @@
 
 #include <QGLWidget>
 #include <QListWidget>
+#include <QProgressDialog>
 #include "windowstatewithmenu.h"
 
 class SpheresWindowState : public WindowStateWithMenu
@@ -36,6 +37,10 @@ private slots:
 private:
     // Helpers
     const SphereView& addNew(const SphereHandle &sh);
+    bool isSphereFile(const QString &fileName) const;
+    std::size_t loadTextFile(const QString &fileName, QProgressDialog &pd);
+    std::size_t loadSphereFile(const QString &fileName, QProgressDialog &pd);
+    std::size_t loadMolecularFile(const QString &fileName, QProgressDialog &pd);
     void updateDisplay();
 
     // Sidebar